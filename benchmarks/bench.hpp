@@ -0,0 +1,78 @@
+#ifndef PAC_BENCH_HPP
+#define PAC_BENCH_HPP
+
+#include <chrono>
+#include <cstddef>
+#include <iomanip>
+#include <iostream>
+#include <string>
+
+namespace bench {
+
+// Keep the optimizer from discarding a value computed in a benchmark loop
+template<class T>
+inline void do_not_optimize( T const& value )
+{
+	asm volatile( "" : : "r,m"( value ) : "memory" );
+}
+
+inline void clobber()
+{
+	asm volatile( "" : : : "memory" );
+}
+
+// Print one result line: name and nanoseconds per operation
+inline void report( std::string const& name, double ns )
+{
+	std::cout << std::left << std::setw( 40 ) << name
+	          << std::right << std::setw( 10 ) << std::fixed
+	          << std::setprecision( 2 ) << ns << " ns/op\n";
+}
+
+// Run func iterations times and report the average nanoseconds per iteration
+template<class Func>
+double run( std::string const& name, std::size_t iterations, Func func )
+{
+	auto beg = std::chrono::steady_clock::now();
+
+	for ( std::size_t i = 0; i < iterations; ++i )
+		func();
+
+	auto end = std::chrono::steady_clock::now();
+
+	double ns = std::chrono::duration<double, std::nano>( end - beg ).count()
+		/ iterations;
+
+	report( name, ns );
+
+	return ns;
+}
+
+// Wall clock nanoseconds of a single call of func
+template<class Func>
+double measure( Func func )
+{
+	auto beg = std::chrono::steady_clock::now();
+
+	func();
+
+	auto end = std::chrono::steady_clock::now();
+
+	return std::chrono::duration<double, std::nano>( end - beg ).count();
+}
+
+// Time a single call of func that performs ops operations, e.g. spread
+// over several threads, and report the wall clock time per operation
+template<class Func>
+double run_total( std::string const& name, std::size_t ops, Func func )
+{
+	double ns = measure( func ) / ops;
+
+	report( name, ns );
+
+	return ns;
+}
+
+} // namespace bench
+
+#endif // PAC_BENCH_HPP
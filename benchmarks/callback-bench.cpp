@@ -0,0 +1,93 @@
+#include "bench.hpp"
+#include "callback.hpp"
+
+#include <array>
+
+namespace {
+
+const std::size_t iterations = 10000000;
+
+struct Widget
+{
+	int clicks = 0;
+
+	int OnClicked( int x )
+	{
+		return clicks += x;
+	}
+};
+
+int free_func( int x )
+{
+	return x + 1;
+}
+
+template<class Make>
+void bench_callback( std::string const& name, Make make )
+{
+	bench::run( name + " construct", iterations,
+	            [&]()
+	            {
+		            pac::callback<int(int)> cb = make();
+		            bench::do_not_optimize( cb );
+	            } );
+
+	pac::callback<int(int)> orig = make();
+	bench::run( name + " copy", iterations,
+	            [&]()
+	            {
+		            pac::callback<int(int)> cb( orig );
+		            bench::do_not_optimize( cb );
+	            } );
+
+	int x = 0;
+	bench::run( name + " invoke", iterations,
+	            [&]()
+	            {
+		            x = orig( x );
+		            bench::do_not_optimize( x );
+	            } );
+}
+
+} // namespace
+
+int main(int, char *[])
+{
+	Widget w;
+	std::array<long, 8> big{};
+
+	std::cout << "sizeof(pac::callback<int(int)>) = "
+	          << sizeof( pac::callback<int(int)> ) << "\n";
+
+	bench_callback( "function pointer",
+	                [](){ return pac::callback<int(int)>( free_func ); } );
+
+	bench_callback( "small lambda",
+	                [&w]()
+	                {
+		                return pac::callback<int(int)>(
+			                [&w](int x) { return w.clicks + x; } );
+	                } );
+
+	bench_callback( "member function",
+	                [&w]()
+	                {
+		                return pac::callback<int(int)>( &Widget::OnClicked, &w );
+	                } );
+
+	bench_callback( "delegate",
+	                [&w]()
+	                {
+		                return pac::callback<int(int)>(
+			                PAC_DELEGATE( &Widget::OnClicked, &w ) );
+	                } );
+
+	bench_callback( "large capture",
+	                [&big]()
+	                {
+		                return pac::callback<int(int)>(
+			                [big](int x) { return int( big[0] ) + x; } );
+	                } );
+
+	return 0;
+}
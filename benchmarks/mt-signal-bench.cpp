@@ -0,0 +1,112 @@
+#include "bench.hpp"
+#include "signal.hpp"
+#include "toe-pool.hpp"
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+namespace {
+
+const std::size_t iterations = 2000000;
+const std::size_t slot_count = 10;
+
+template<class Signal>
+void connect_slots( Signal& sig, std::atomic<long>& total )
+{
+	for ( std::size_t i = 0; i < slot_count; ++i )
+		sig.connect( [&total]( int x ) { total.fetch_add( x, std::memory_order_relaxed ); } ).detach();
+}
+
+// Aggregate emit throughput with threads emitting concurrently, reported
+// as wall clock time per emission
+void bench_threads( std::size_t threads )
+{
+	pac::signal< void(int), pac::mt_policy > sig;
+	std::atomic<long> total{ 0 };
+	connect_slots( sig, total );
+
+	auto per_thread = iterations / threads;
+
+	auto emit_all = [&]()
+	{
+		std::vector<std::thread> emitters;
+
+		for ( std::size_t t = 0; t < threads; ++t )
+			emitters.emplace_back(
+				[&]()
+				{
+					for ( std::size_t i = 0; i < per_thread; ++i )
+						sig.emit( 1 );
+				} );
+
+		for ( auto& e : emitters )
+			e.join();
+	};
+
+	bench::run_total( "mt emit " + std::to_string( slot_count ) + " slots, "
+	                  + std::to_string( threads ) + " threads",
+	                  per_thread * threads, emit_all );
+}
+
+// A broadcast to heavyweight independent slots, emitted on the calling
+// thread and spread over pools of workers
+void bench_parallel()
+{
+	pac::signal<int(int)> sig;
+
+	for ( std::size_t i = 0; i < 200; ++i ) {
+		sig.connect(
+			[]( int x )
+			{
+				for ( int n = 0; n < 2000; ++n )
+					bench::do_not_optimize( x += n );
+				return x;
+			} ).detach();
+	}
+
+	bench::run( "emit 200 heavy slots", 200,
+	            [&]()
+	            {
+		            auto r = sig.emit( 1 );
+		            bench::do_not_optimize( r );
+	            } );
+
+	for ( std::size_t workers : { 1, 3, 7 } ) {
+		pac::toe_pool pool( workers );
+
+		bench::run( "emit_parallel 200 heavy slots, " + std::to_string( workers + 1 )
+		            + " threads", 200,
+		            [&]()
+		            {
+			            auto r = sig.emit_parallel( pool, 1 );
+			            bench::do_not_optimize( r );
+		            } );
+	}
+}
+
+} // namespace
+
+int main(int, char *[])
+{
+	std::atomic<long> total{ 0 };
+
+	pac::signal< void(int) > st;
+	connect_slots( st, total );
+	bench::run( "st emit " + std::to_string( slot_count ) + " slots", iterations,
+	            [&]() { st.emit( 1 ); } );
+
+	pac::signal< void(int), pac::mt_policy > mt;
+	connect_slots( mt, total );
+	bench::run( "mt emit " + std::to_string( slot_count ) + " slots", iterations,
+	            [&]() { mt.emit( 1 ); } );
+
+	std::cout << "hardware threads: " << std::thread::hardware_concurrency() << "\n";
+
+	for ( std::size_t threads : { 1, 2, 4, 8 } )
+		bench_threads( threads );
+
+	bench_parallel();
+
+	return 0;
+}
@@ -0,0 +1,358 @@
+#include "bench.hpp"
+#include "keyed-signal.hpp"
+#include "signal.hpp"
+#include "static-signal.hpp"
+
+#include <vector>
+
+namespace {
+
+const std::size_t total_invocations = 20000000;
+
+struct Receiver
+{
+	int total = 0;
+
+	void OnValue( int x )
+	{
+		total += x;
+	}
+};
+
+void bench_emit( std::size_t slot_count )
+{
+	std::vector<Receiver> receivers( slot_count );
+	pac::signal<void(int)> sig;
+	pac::signal<int(int)> sigret;
+
+	for ( auto& r : receivers ) {
+		sig.connect( &Receiver::OnValue, &r ).detach();
+		sigret.connect( [&r]( int x ) { return r.total += x; } ).detach();
+	}
+
+	auto iterations = total_invocations / slot_count;
+	auto name = std::to_string( slot_count ) + " slots";
+
+	bench::run( "emit void(int) " + name, iterations,
+	            [&]()
+	            {
+		            sig.emit( 1 );
+	            } );
+
+	int sum = 0;
+	bench::run( "emit_with int(int) " + name, iterations,
+	            [&]()
+	            {
+		            sigret.emit_with( [&sum]( int x ) { sum += x; }, 1 );
+	            } );
+	bench::do_not_optimize( sum );
+
+	bench::run( "emit int(int) collect " + name, iterations,
+	            [&]()
+	            {
+		            auto results = sigret.emit( 1 );
+		            bench::do_not_optimize( results );
+	            } );
+
+	bench::run( "emit_with<last_value> " + name, iterations,
+	            [&]()
+	            {
+		            sum = sigret.emit_with<pac::last_value>( 1 );
+	            } );
+	bench::do_not_optimize( sum );
+}
+
+// Connection churn, as with panels coming and going, and toggling a slot
+void bench_connect( std::size_t slot_count )
+{
+	std::vector<Receiver> receivers( slot_count );
+	std::vector<pac::connection> cons( slot_count );
+	pac::signal<void(int)> sig;
+
+	bench::run( "connect+disconnect " + std::to_string( slot_count ) + " slots",
+	            1000,
+	            [&]()
+	            {
+		            for ( std::size_t i = 0; i < slot_count; ++i )
+			            cons[i] = sig.connect( &Receiver::OnValue, &receivers[i] );
+
+		            for ( auto& con : cons )
+			            con.disconnect();
+	            } );
+
+	for ( std::size_t i = 0; i < slot_count; ++i )
+		cons[i] = sig.connect( &Receiver::OnValue, &receivers[i] );
+
+	std::size_t next = 0;
+	bench::run( "block+unblock", total_invocations,
+	            [&]()
+	            {
+		            auto& con = cons[next++ % slot_count];
+		            con.block();
+		            con.unblock();
+	            } );
+}
+
+// Tearing down a panel with slots on many signals, one connection at a
+// time and as a group, then emitting each signal once, which is when the
+// group's slots are purged
+void bench_teardown( std::size_t signal_count, std::size_t slots_per_signal )
+{
+	std::vector<Receiver> receivers( slots_per_signal );
+	std::vector< pac::signal<void(int)> > sigs( signal_count );
+	std::vector<pac::connection> cons;
+	auto name = std::to_string( signal_count * slots_per_signal ) + " slots";
+
+	auto connect = [&]( pac::connection_group *group )
+		{
+			for ( auto& sig : sigs )
+				for ( auto& r : receivers ) {
+					if ( group )
+						sig.connect( *group, &Receiver::OnValue, &r );
+					else
+						cons.push_back( sig.connect( &Receiver::OnValue, &r ) );
+				}
+		};
+
+	auto emit_all = [&]()
+		{
+			for ( auto& sig : sigs )
+				sig.emit( 1 );
+		};
+
+	double connections = 0, connections_purge = 0;
+	double grouped = 0, grouped_purge = 0;
+
+	for ( int i = 0; i < 100; ++i ) {
+		connect( nullptr );
+		connections += bench::measure( [&]() { cons.clear(); } );
+		connections_purge += bench::measure( emit_all );
+
+		pac::connection_group group;
+		connect( &group );
+		grouped += bench::measure( [&]() { group.disconnect(); } );
+		grouped_purge += bench::measure( emit_all );
+	}
+
+	bench::report( "teardown connections " + name, connections / 100 );
+	bench::report( "  then emit all", connections_purge / 100 );
+	bench::report( "teardown group " + name, grouped / 100 );
+	bench::report( "  then emit all", grouped_purge / 100 );
+}
+
+// A click always forwarded to the same two handlers: called by hand,
+// through a static_signal and through a signal
+void bench_static()
+{
+	Receiver a, b;
+
+	int x = 1;
+	bench::run( "direct call 2 handlers", total_invocations,
+	            [&]()
+	            {
+		            a.OnValue( x );
+		            b.OnValue( x + 1 );
+		            bench::clobber();
+	            } );
+
+	auto fixed = pac::make_static_signal<void(int)>(
+		[&a]( int x ) { a.OnValue( x ); },
+		[&b]( int x ) { b.OnValue( x + 1 ); } );
+
+	bench::run( "static_signal 2 slots", total_invocations,
+	            [&]()
+	            {
+		            fixed.emit( x );
+		            bench::clobber();
+	            } );
+
+	pac::signal<void(int)> sig;
+	sig.connect( &Receiver::OnValue, &a ).detach();
+	sig.connect( [&b]( int x ) { b.OnValue( x + 1 ); } ).detach();
+
+	bench::run( "signal 2 slots", total_invocations,
+	            [&]()
+	            {
+		            sig.emit( 1 );
+	            } );
+
+	bench::do_not_optimize( a.total + b.total );
+}
+
+// Input routing: a modal overlay connected with a high priority consumes
+// every event, against all handlers running
+void bench_stop( std::size_t slot_count )
+{
+	std::vector<Receiver> receivers( slot_count );
+	pac::signal<void(int)> sig;
+
+	for ( auto& r : receivers )
+		sig.connect( &Receiver::OnValue, &r ).detach();
+
+	auto name = std::to_string( slot_count ) + " slots";
+
+	bench::run( "emit all handlers " + name, total_invocations / slot_count,
+	            [&]()
+	            {
+		            sig.emit( 1 );
+	            } );
+
+	Receiver modal;
+	sig.connect( 100, [&]( int x ) { modal.OnValue( x ); sig.stop_emission(); } ).detach();
+
+	bench::run( "emit consumed by modal " + name, total_invocations / slot_count,
+	            [&]()
+	            {
+		            sig.emit( 1 );
+	            } );
+
+	bench::do_not_optimize( modal.total );
+}
+
+// Emit with all but one in ten slots blocked, as with hidden panels
+void bench_blocked( std::size_t slot_count )
+{
+	std::vector<Receiver> receivers( slot_count );
+	std::vector<pac::connection> cons;
+	pac::signal<void(int)> sig;
+
+	for ( auto& r : receivers )
+		cons.push_back( sig.connect( &Receiver::OnValue, &r ) );
+
+	for ( std::size_t i = 0; i < cons.size(); ++i )
+		if ( i % 10 != 0 )
+			cons[i].block();
+
+	bench::run( "emit 90% blocked " + std::to_string( slot_count ) + " slots",
+	            total_invocations / slot_count,
+	            [&]()
+	            {
+		            sig.emit( 1 );
+	            } );
+}
+
+// connection_block around each emission: one slot muted while the rest
+// of a large signal is emitted
+void bench_block_scope( std::size_t slot_count )
+{
+	std::vector<Receiver> receivers( slot_count );
+	std::vector<pac::connection> cons;
+	pac::signal<void(int)> sig;
+
+	for ( auto& r : receivers )
+		cons.push_back( sig.connect( &Receiver::OnValue, &r ) );
+
+	bench::run( "block, emit, unblock " + std::to_string( slot_count ) + " slots",
+	            total_invocations / slot_count,
+	            [&]()
+	            {
+		            pac::connection_block muted{ cons[slot_count / 2] };
+		            sig.emit( 1 );
+	            } );
+}
+
+// A burst of updates delivered item by item, slot-major, and to batch
+// receivers
+void bench_batch( std::size_t slot_count, std::size_t batch_size )
+{
+	std::vector<int> values( batch_size, 1 );
+	std::vector<Receiver> receivers( slot_count );
+	pac::signal<void(int)> sig;
+	pac::signal<void(int)> sigbatch;
+
+	for ( auto& r : receivers ) {
+		sig.connect( &Receiver::OnValue, &r ).detach();
+		sigbatch.connect_batch(
+			[&r]( pac::span<int const> batch )
+			{
+				for ( auto v : batch )
+					r.total += v;
+			} ).detach();
+	}
+
+	auto iterations = total_invocations / ( slot_count * batch_size );
+	auto name = std::to_string( batch_size ) + " items "
+		+ std::to_string( slot_count ) + " slots";
+
+	bench::run( "emit per item " + name, iterations,
+	            [&]()
+	            {
+		            for ( auto v : values )
+			            sig.emit( v );
+	            } );
+
+	bench::run( "emit_batch " + name, iterations,
+	            [&]()
+	            {
+		            sig.emit_batch( values );
+	            } );
+
+	bench::run( "emit_batch to batch slots " + name, iterations,
+	            [&]()
+	            {
+		            sigbatch.emit_batch( values );
+	            } );
+}
+
+// Per-entity subscriptions: a shared signal whose slots filter on the id
+// against a keyed signal
+void bench_keyed( std::size_t entities )
+{
+	std::vector<Receiver> receivers( entities );
+	pac::signal<void(std::size_t, int)> shared;
+	pac::keyed_signal<std::size_t, void(int)> keyed;
+
+	for ( std::size_t id = 0; id < entities; ++id ) {
+		auto& r = receivers[id];
+
+		shared.connect(
+			[&r, id]( std::size_t target, int x )
+			{
+				if ( target == id )
+					r.OnValue( x );
+			} ).detach();
+
+		keyed.connect( id, &Receiver::OnValue, &r ).detach();
+	}
+
+	std::size_t next = 0;
+	auto name = std::to_string( entities ) + " entities";
+
+	bench::run( "shared signal, filtering " + name, total_invocations / entities,
+	            [&]()
+	            {
+		            shared.emit( next++ % entities, 1 );
+	            } );
+
+	bench::run( "keyed_signal " + name, total_invocations / entities,
+	            [&]()
+	            {
+		            keyed.emit( next++ % entities, 1 );
+	            } );
+}
+
+} // namespace
+
+int main(int, char *[])
+{
+	for ( std::size_t n : { 1, 10, 100, 10000 } )
+		bench_emit( n );
+
+	bench_static();
+
+	bench_blocked( 10000 );
+
+	bench_block_scope( 10000 );
+
+	bench_stop( 100 );
+
+	bench_connect( 1000 );
+
+	bench_teardown( 100, 10 );
+
+	bench_batch( 10, 1000 );
+
+	bench_keyed( 1000 );
+
+	return 0;
+}
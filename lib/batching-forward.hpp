@@ -0,0 +1,241 @@
+/*
+ * This file is part of PAC
+ *
+ * PAC is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * PAC is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with PAC.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef PAC_BATCHING_FORWARD_HPP
+#define PAC_BATCHING_FORWARD_HPP
+
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "context.hpp"
+#include "signal.hpp"
+#include "span.hpp"
+
+namespace pac {
+
+template<class OrigSignal>
+class batching_forward;
+
+// Forwards the scalar emissions of a void(T) signal as spans of T.  Values
+// are gathered until threshold of them are pending or max_delay_us has
+// passed since the first one, then delivered on toe in one emission; no
+// batch holds more than threshold values.  Batch buffers are recycled, so
+// once warmed up forwarding allocates nothing.  Receivers always run on
+// toe; connect them before values start flowing or from toe itself.  toe
+// must outlive the forward
+template<template<class...> class Signal, class T, class... Extra>
+class batching_forward< Signal<void(T), Extra...> >
+{
+public:
+	using SignalType = Signal<void(T), Extra...>;
+	using value_type = typename std::decay<T>::type;
+	using batch_signal_type = signal< void( span<value_type const> ) >;
+
+private:
+	using clock_type = context::clock_type;
+	using buffer_type = std::vector<value_type>;
+
+	struct state
+	{
+		toe& target;
+		std::size_t threshold;
+		long long max_delay_us;
+
+		std::mutex mutex;
+
+		// Values of the open batch, and when its first value arrived
+		buffer_type buffer;
+		clock_type::time_point opened;
+
+		// Closed batches waiting for toe, in order; toe swaps them with
+		// delivering and hands the emptied buffers back through spare
+		std::vector<buffer_type> ready;
+		std::vector<buffer_type> delivering;
+		std::vector<buffer_type> spare;
+
+		bool delivery_posted = false;
+
+		// At most one deadline timer is queued; when it fires for a batch
+		// that has already gone out, it is rearmed for the open one
+		bool timer_armed = false;
+
+		batch_signal_type out;
+
+		state( toe& t, std::size_t thr, long long delay )
+			: target( t ), threshold( thr ), max_delay_us( delay )
+		{
+			buffer.reserve( threshold );
+		}
+
+		template<class V>
+		void push( std::shared_ptr<state> const& self, V&& value )
+		{
+			bool arm = false;
+			bool post = false;
+
+			{
+				std::lock_guard<std::mutex> lock( mutex );
+
+				if ( buffer.empty() ) {
+					opened = clock_type::now();
+					arm = !timer_armed;
+					timer_armed = true;
+				}
+
+				buffer.push_back( std::forward<V>(value) );
+
+				if ( buffer.size() >= threshold )
+					post = close_batch();
+			}
+
+			if ( arm )
+				target.add_timeout( max_delay_us, [self]() { self->expire( self ); } );
+
+			if ( post )
+				target.add_callback( [self]() { self->deliver(); } );
+		}
+
+		void post_flush( std::shared_ptr<state> const& self )
+		{
+			bool post;
+
+			{
+				std::lock_guard<std::mutex> lock( mutex );
+				post = !buffer.empty() && close_batch();
+			}
+
+			if ( post )
+				target.add_callback( [self]() { self->deliver(); } );
+		}
+
+		// Called with mutex held: queue the open batch for delivery and
+		// open the next one in a recycled buffer.  Returns whether a
+		// delivery has to be posted
+		bool close_batch()
+		{
+			ready.push_back( std::move( buffer ) );
+
+			if ( spare.empty() ) {
+				buffer = buffer_type();
+				buffer.reserve( threshold );
+			} else {
+				buffer = std::move( spare.back() );
+				spare.pop_back();
+			}
+
+			bool post = !delivery_posted;
+			delivery_posted = true;
+
+			return post;
+		}
+
+		// Runs on target
+		void expire( std::shared_ptr<state> const& self )
+		{
+			long long remaining = 0;
+
+			{
+				std::lock_guard<std::mutex> lock( mutex );
+
+				timer_armed = false;
+				if ( buffer.empty() )
+					return;
+
+				remaining = std::chrono::duration_cast<std::chrono::microseconds>(
+					opened + std::chrono::microseconds( max_delay_us )
+					- clock_type::now() ).count();
+
+				if ( remaining > 0 )
+					timer_armed = true;
+				else
+					close_batch();
+			}
+
+			if ( remaining > 0 )
+				target.add_timeout( remaining, [self]() { self->expire( self ); } );
+			else
+				deliver();
+		}
+
+		// Runs on target
+		void deliver()
+		{
+			{
+				std::lock_guard<std::mutex> lock( mutex );
+
+				std::swap( ready, delivering );
+				delivery_posted = false;
+			}
+
+			for ( auto const& batch : delivering )
+				out.emit( span<value_type const>( batch ) );
+
+			{
+				std::lock_guard<std::mutex> lock( mutex );
+
+				for ( auto& batch : delivering ) {
+					batch.clear();
+					spare.push_back( std::move( batch ) );
+				}
+			}
+
+			delivering.clear();
+		}
+	};
+
+	std::shared_ptr<state> st;
+	connection source;
+
+public:
+	batching_forward( SignalType& sig, toe& target, std::size_t threshold,
+	                  long long max_delay_us )
+		: st( std::make_shared<state>( target, threshold, max_delay_us ) )
+	{
+		auto self = st;
+		source = sig.connect(
+			callback<void(T)>(
+				[self]( value_type const& value )
+				{
+					self->push( self, value );
+				} ) );
+	}
+
+	batching_forward( batching_forward const& ) = delete;
+	batching_forward& operator=( batching_forward const& ) = delete;
+
+	template<class... Args>
+	connection connect( Args&&... args )
+	{
+		return st->out.connect( std::forward<Args>(args)... );
+	}
+
+	// Deliver the pending values on toe without waiting for the
+	// threshold or the deadline
+	void flush()
+	{
+		st->post_flush( st );
+	}
+};
+
+} // namespace pac
+
+#endif // PAC_BATCHING_FORWARD_HPP
@@ -30,84 +30,586 @@
 #include <functional>
 #include <utility>
 #include <memory>
+#include <new>
+#include <type_traits>
+
+#include "memory-resource.hpp"
+
+// Number of pointers worth of storage a callback keeps inline; callables that
+// fit are stored in place, larger ones fall back to a heap allocation whose
+// owning pointer takes two of them
+#ifndef PAC_CALLBACK_INLINE_POINTERS
+#define PAC_CALLBACK_INLINE_POINTERS 3
+#endif
 
 namespace pac {
 
+// Member function pointer bound to an object (raw or smart pointer) as
+// stored by the callback types; the pointer is held by value, never as a
+// reference to the caller's variable
+template<class PMemFunc, class T>
+struct memfunc_binding
+{
+	T obj;
+	PMemFunc mfunc;
+
+	template<class M, class U>
+	memfunc_binding( M&& m, U&& o )
+		: obj( std::forward<U>(o) ), mfunc( std::forward<M>(m) )
+	{}
+
+	template<class... A>
+	decltype(auto) operator()(A&&... args)
+	{
+		// Use (*obj).*mfunc for smart pointers (e.g. unique_ptr)
+		return ( (*obj).*mfunc )( std::forward<A>(args)... );
+	}
+};
+
+template<class PMemFunc, class T>
+auto bind_memfunc( PMemFunc mfunc, T&& obj, std::true_type )
+	-> memfunc_binding< PMemFunc, typename std::decay<T>::type >
+{
+	return { mfunc, std::forward<T>(obj) };
+}
+
+// A move-only owner passed as an lvalue, e.g. a unique_ptr, stays with the
+// caller; bind the object it owns instead
+template<class PMemFunc, class T>
+auto bind_memfunc( PMemFunc mfunc, T& obj, std::false_type )
+	-> memfunc_binding< PMemFunc, decltype( std::addressof( *obj ) ) >
+{
+	return { mfunc, std::addressof( *obj ) };
+}
+
+template<class PMemFunc, class T>
+auto bind_memfunc( PMemFunc mfunc, T&& obj )
+{
+	return bind_memfunc(
+		mfunc, std::forward<T>(obj),
+		std::is_constructible< typename std::decay<T>::type, T&& >() );
+}
+
+template<class PMemFunc>
+struct memfunc_traits;
+
+template<class T, class Ret, class... Args>
+struct memfunc_traits< Ret (T::*)(Args...) >
+{
+	using class_type = T;
+	using signature = Ret(Args...);
+};
+
+template<class T, class Ret, class... Args>
+struct memfunc_traits< Ret (T::*)(Args...) const >
+{
+	using class_type = T const;
+	using signature = Ret(Args...);
+};
+
+template<class Signature, bool Copyable>
+class basic_callback;
+
 template<class Signature>
-class callback;
+class delegate;
 
+// Object pointer plus a static thunk calling a member function fixed at
+// compile time; trivially copyable, never allocates and calls the member
+// directly instead of through a pointer-to-member
 template<class Ret, class... Args>
-class callback< Ret(Args...) >
+class delegate< Ret(Args...) >
+{
+	using thunk_type = Ret (*)( void *, Args&&... );
+
+	void *obj;
+	thunk_type thunk;
+
+	template<class T, class PMemFunc, PMemFunc mfunc>
+	static Ret invoke( void *self, Args&&... args )
+	{
+		T *o = static_cast<T *>( *static_cast<void **>( self ) );
+		return ( o->*mfunc )( std::forward<Args>(args)... );
+	}
+
+	template<class, bool>
+	friend class basic_callback;
+
+public:
+	delegate()
+		: obj( nullptr ), thunk( nullptr )
+	{}
+
+	template<class PMemFunc, PMemFunc mfunc, class T>
+	static delegate bind( T *o )
+	{
+		using class_type = typename memfunc_traits<PMemFunc>::class_type;
+
+		delegate d;
+		d.obj = const_cast<void *>(
+			static_cast<void const *>( static_cast<class_type *>( o ) ) );
+		d.thunk = &invoke<class_type, PMemFunc, mfunc>;
+		return d;
+	}
+
+	explicit operator bool() const
+	{
+		return thunk != nullptr;
+	}
+
+	Ret operator()(Args... args) const
+	{
+		if ( thunk )
+			return thunk( const_cast<void **>( &obj ),
+			              std::forward<Args>(args)... );
+		return Ret();
+	}
+
+	bool operator==( delegate const& other ) const
+	{
+		return obj == other.obj && thunk == other.thunk;
+	}
+
+	bool operator!=( delegate const& other ) const
+	{
+		return !( *this == other );
+	}
+};
+
+template<class PMemFunc, PMemFunc mfunc, class T>
+auto make_delegate( T *obj )
+	-> delegate< typename memfunc_traits<PMemFunc>::signature >
+{
+	using delegate_type =
+		delegate< typename memfunc_traits<PMemFunc>::signature >;
+
+	return delegate_type::template bind<PMemFunc, mfunc>( obj );
+}
+
+// PAC_DELEGATE( &RootController::OnButtonClicked, this )
+#define PAC_DELEGATE( mfunc, obj ) \
+	::pac::make_delegate< decltype( mfunc ), mfunc >( obj )
+
+// Storage and dispatch shared by callback and unique_callback.  Callables
+// that fit are kept in the inline buffer, others on the heap (shared for
+// callback, owned for unique_callback) allocated from a memory_resource;
+// either way invocation is a single call through a static thunk and
+// trivially copyable callables are copied without any bookkeeping
+template<class Ret, class... Args, bool Copyable>
+class basic_callback< Ret(Args...), Copyable >
 {
-	struct concept
+protected:
+	enum class operation
 	{
-		virtual ~concept() {}
-		virtual Ret operator()(Args... args) = 0;
+		copy,
+		move,
+		destroy
 	};
 
+	using storage_type = typename std::aligned_storage<
+		PAC_CALLBACK_INLINE_POINTERS * sizeof(void *), alignof(void *)>::type;
+
+	// Arguments travel by reference from operator() down to the target, so
+	// a by-value parameter is copied once on entry and only moved after
+	using invoke_type = Ret (*)( void *, Args&&... );
+	using manage_type = void (*)( operation, void *, void * );
+
+	template<class Func>
+	using heap_holder = typename std::conditional<
+		Copyable, std::shared_ptr<Func>, resource_unique_ptr<Func> >::type;
+
+	template<class Func>
+	struct fits_locally
+		: std::integral_constant<
+			bool,
+			sizeof( Func ) <= sizeof( storage_type ) &&
+			alignof( Func ) <= alignof( storage_type ) &&
+			std::is_nothrow_move_constructible<Func>::value &&
+			( !Copyable || std::is_copy_constructible<Func>::value ) >
+	{};
+
 	template<class Func>
-	struct model : concept
+	struct is_trivial
+		: std::integral_constant<
+			bool,
+			std::is_trivially_copyable<Func>::value &&
+			std::is_trivially_destructible<Func>::value >
+	{};
+
+	storage_type storage;
+	invoke_type invoke;
+	manage_type manage;
+
+	template<class Func>
+	static Ret invoke_local( void *data, Args&&... args )
+	{
+		return (*static_cast<Func *>( data ))( std::forward<Args>(args)... );
+	}
+
+	template<class Func>
+	static Ret invoke_heap( void *data, Args&&... args )
 	{
-		Func func;
+		return (**static_cast<heap_holder<Func> *>( data ))(
+			std::forward<Args>(args)... );
+	}
 
-		Ret operator()(Args... args)
-		{
-			return (func)( std::forward<Args>(args)... );
+	template<class Func>
+	static void copy_local( void *dst, void *src, std::true_type )
+	{
+		::new (dst) Func( *static_cast<Func const *>( src ) );
+	}
+
+	template<class Func>
+	static void copy_local( void *, void *, std::false_type )
+	{}
+
+	template<class Func>
+	static void manage_local( operation op, void *dst, void *src )
+	{
+		switch ( op ) {
+		case operation::copy:
+			copy_local<Func>( dst, src, std::integral_constant<bool, Copyable>() );
+			break;
+		case operation::move:
+			::new (dst) Func( std::move( *static_cast<Func *>( src ) ) );
+			break;
+		case operation::destroy:
+			static_cast<Func *>( dst )->~Func();
+			break;
 		}
+	}
 
-		model(Func f)
-			: func(f)
-		{}
-	};
+	template<class Func>
+	static manage_type local_manager( std::true_type )
+	{
+		return nullptr;
+	}
 
-	template<class PMemFunc, class T>
-	struct model_memfunc : concept
+	template<class Func>
+	static manage_type local_manager( std::false_type )
+	{
+		return &manage_local<Func>;
+	}
+
+	template<class Func>
+	static invoke_type local_invoker( Func const& )
+	{
+		return &invoke_local<Func>;
+	}
+
+	// A delegate's thunk already has the shape of a callback invoker, so it
+	// is called directly on the copy held in storage
+	static invoke_type local_invoker( delegate<Ret(Args...)> const& d )
+	{
+		return d.thunk;
+	}
+
+	template<class T, class Func>
+	static std::shared_ptr<T> make_holder( memory_resource *res, Func&& func,
+	                                       std::true_type )
+	{
+		return std::allocate_shared<T>( polymorphic_allocator<T>( res ),
+		                                std::forward<Func>(func) );
+	}
+
+	template<class T, class Func>
+	static resource_unique_ptr<T> make_holder( memory_resource *res, Func&& func,
+	                                           std::false_type )
+	{
+		return allocate_unique<T>( res, std::forward<Func>(func) );
+	}
+
+	template<class Func>
+	void assign( Func&& func, memory_resource *, std::true_type )
+	{
+		using func_type = typename std::decay<Func>::type;
+
+		invoke = local_invoker( func );
+		manage = local_manager<func_type>( is_trivial<func_type>() );
+		::new (static_cast<void *>(&storage)) func_type( std::forward<Func>(func) );
+	}
+
+	template<class Func>
+	void assign( Func&& func, memory_resource *res, std::false_type )
+	{
+		using func_type = typename std::decay<Func>::type;
+		using holder_type = heap_holder<func_type>;
+
+		static_assert( sizeof( holder_type ) <= sizeof( storage_type ) &&
+		               alignof( holder_type ) <= alignof( storage_type ),
+		               "PAC_CALLBACK_INLINE_POINTERS must leave room for the heap holder" );
+
+		::new (static_cast<void *>(&storage))
+			holder_type( make_holder<func_type>(
+				             res, std::forward<Func>(func),
+				             std::integral_constant<bool, Copyable>() ) );
+		invoke = &invoke_heap<func_type>;
+		manage = &manage_local<holder_type>;
+	}
+
+	template<class Func>
+	void assign( Func&& func, memory_resource *res = get_default_resource() )
+	{
+		assign( std::forward<Func>(func), res,
+		        fits_locally< typename std::decay<Func>::type >() );
+	}
+
+	void copy_from( basic_callback const& other )
 	{
-		T obj;
-		PMemFunc mfunc;
+		if ( other.manage )
+			other.manage( operation::copy, &storage,
+			              const_cast<storage_type *>( &other.storage ) );
+		else
+			storage = other.storage;
 
-		template<class M, class U>
-		model_memfunc( M&& m, U&& o )
-			: obj( std::forward<U>(o) ), mfunc( std::forward<M>(m) )
-		{}
+		invoke = other.invoke;
+		manage = other.manage;
+	}
 
-		Ret operator()(Args... args)
-		{
-			// Use (*obj).*mfunc for smart pointers (e.g. unique_ptr)
-			return ( (*obj).*mfunc )( std::forward<Args>(args)... );
+	void move_from( basic_callback& other ) noexcept
+	{
+		if ( other.manage ) {
+			other.manage( operation::move, &storage, &other.storage );
+			other.manage( operation::destroy, &other.storage, nullptr );
 		}
-	};
+		else {
+			storage = other.storage;
+		}
+
+		invoke = other.invoke;
+		manage = other.manage;
+
+		other.invoke = nullptr;
+		other.manage = nullptr;
+	}
+
+	void reset() noexcept
+	{
+		if ( manage )
+			manage( operation::destroy, &storage, nullptr );
+
+		invoke = nullptr;
+		manage = nullptr;
+	}
+
+	// An empty callback returns a default constructed result; results that
+	// cannot be default constructed (e.g. tuples of references) throw
+	static Ret empty_result( std::true_type )
+	{
+		return Ret();
+	}
+
+	static Ret empty_result( std::false_type )
+	{
+		throw std::bad_function_call();
+	}
+
+	basic_callback()
+		: invoke( nullptr ), manage( nullptr )
+	{}
+
+	~basic_callback()
+	{
+		reset();
+	}
+
+public:
+	explicit operator bool() const
+	{
+		return invoke != nullptr;
+	}
+
+	Ret operator()(Args... args)
+	{
+		if ( invoke )
+			return invoke( &storage, std::forward<Args>(args)... );
 
-	std::shared_ptr<concept> con;
+		return empty_result(
+			std::integral_constant<
+				bool,
+				std::is_void<Ret>::value ||
+				std::is_default_constructible<Ret>::value >() );
+	}
+};
+
+template<class Signature>
+class callback;
 
+template<class Ret, class... Args>
+class callback< Ret(Args...) >
+	: public basic_callback< Ret(Args...), true >
+{
 public:
 	~callback() = default;
 
-	callback()
-		: con( nullptr )
-	{}
+	callback() = default;
 
 	template<class Func>
 	callback(Func func)
-		: con( std::make_shared<model< Func >>(func) )
-	{}
+	{
+		this->assign( std::move(func) );
+	}
+
+	// Heap storage, if the callable needs it, comes from res
+	template<class Func>
+	callback(std::allocator_arg_t, memory_resource *res, Func func)
+	{
+		this->assign( std::move(func), res );
+	}
 
 	template<class PMemFunc, class T>
 	callback(PMemFunc memfunc, T&& obj)
-		: con( std::make_shared<model_memfunc<PMemFunc, T>>( memfunc, std::forward<T>(obj) ) )
-	{}
+	{
+		this->assign( bind_memfunc( memfunc, std::forward<T>(obj) ) );
+	}
 
-	callback(callback&&) = default;
-	callback& operator=(callback&&) = default;
+	template<class PMemFunc, class T>
+	callback(std::allocator_arg_t, memory_resource *res, PMemFunc memfunc, T&& obj)
+	{
+		this->assign( bind_memfunc( memfunc, std::forward<T>(obj) ), res );
+	}
 
-	callback(callback const&) = default;
-	callback& operator=(callback const&) = default;
+	callback(callback&& other) noexcept
+	{
+		this->move_from( other );
+	}
 
-	Ret operator()(Args... args)
+	callback& operator=(callback&& other) noexcept
 	{
-		if ( con )
-			return (*con)( std::forward<Args>(args)... );
-		return Ret();
+		if ( this != &other ) {
+			this->reset();
+			this->move_from( other );
+		}
+		return *this;
+	}
+
+	callback(callback const& other)
+	{
+		this->copy_from( other );
+	}
+
+	callback& operator=(callback const& other)
+	{
+		if ( this != &other ) {
+			this->reset();
+			this->copy_from( other );
+		}
+		return *this;
+	}
+};
+
+template<class Signature>
+class unique_callback;
+
+// Move-only callback owning its callable outright; it can hold move-only
+// captures (unique_ptr, promise) and never shares or refcounts its target
+template<class Ret, class... Args>
+class unique_callback< Ret(Args...) >
+	: public basic_callback< Ret(Args...), false >
+{
+public:
+	~unique_callback() = default;
+
+	unique_callback() = default;
+
+	template<class Func>
+	unique_callback(Func func)
+	{
+		this->assign( std::move(func) );
+	}
+
+	// Heap storage, if the callable needs it, comes from res
+	template<class Func>
+	unique_callback(std::allocator_arg_t, memory_resource *res, Func func)
+	{
+		this->assign( std::move(func), res );
+	}
+
+	template<class PMemFunc, class T>
+	unique_callback(PMemFunc memfunc, T&& obj)
+	{
+		this->assign( bind_memfunc( memfunc, std::forward<T>(obj) ) );
+	}
+
+	template<class PMemFunc, class T>
+	unique_callback(std::allocator_arg_t, memory_resource *res, PMemFunc memfunc, T&& obj)
+	{
+		this->assign( bind_memfunc( memfunc, std::forward<T>(obj) ), res );
+	}
+
+	unique_callback(unique_callback&& other) noexcept
+	{
+		this->move_from( other );
+	}
+
+	unique_callback& operator=(unique_callback&& other) noexcept
+	{
+		if ( this != &other ) {
+			this->reset();
+			this->move_from( other );
+		}
+		return *this;
+	}
+
+	unique_callback(unique_callback const&) = delete;
+	unique_callback& operator=(unique_callback const&) = delete;
+};
+
+// Non-owning reference to any callable (including a pac::callback) for
+// synchronous invocation; it never allocates or touches a refcount, so the
+// referenced callable must outlive the callback_ref
+template<class Signature>
+class callback_ref;
+
+template<class Ret, class... Args>
+class callback_ref< Ret(Args...) >
+{
+	union target_type
+	{
+		void *obj;
+		Ret (*func)(Args...);
+	};
+
+	target_type target;
+	Ret (*thunk)( target_type, Args&&... );
+
+	template<class Func>
+	static Ret invoke_object( target_type t, Args&&... args )
+	{
+		return (*static_cast<Func *>( t.obj ))( std::forward<Args>(args)... );
+	}
+
+	static Ret invoke_function( target_type t, Args&&... args )
+	{
+		return t.func( std::forward<Args>(args)... );
+	}
+
+public:
+	template<class Func,
+	         class = typename std::enable_if<
+		         !std::is_same< typename std::decay<Func>::type,
+		                        callback_ref >::value &&
+		         !std::is_function<
+			         typename std::remove_reference<Func>::type >::value
+		         >::type>
+	callback_ref( Func&& func )
+		: thunk( &invoke_object< typename std::remove_reference<Func>::type > )
+	{
+		target.obj = const_cast<void *>(
+			static_cast<void const volatile *>( std::addressof( func ) ) );
+	}
+
+	callback_ref( Ret (*func)(Args...) )
+		: thunk( &invoke_function )
+	{
+		target.func = func;
+	}
+
+	callback_ref( callback_ref const& ) = default;
+	callback_ref& operator=( callback_ref const& ) = default;
+
+	Ret operator()(Args... args) const
+	{
+		return thunk( target, std::forward<Args>(args)... );
 	}
 };
 
@@ -0,0 +1,142 @@
+/*
+ * This file is part of PAC
+ *
+ * PAC is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * PAC is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with PAC.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef PAC_COMBINER_HPP
+#define PAC_COMBINER_HPP
+
+#include <type_traits>
+#include <utility>
+
+namespace pac {
+
+// A combiner reduces the results of a signal's slots as they are produced.
+// It is called with each result and returns whether further slots need to
+// run; result() yields the combined value once the emission is done.
+
+template<class T>
+class last_value
+{
+	T value{};
+
+public:
+	using result_type = T;
+
+	bool operator()( T v )
+	{
+		value = std::move( v );
+		return true;
+	}
+
+	result_type result()
+	{
+		return std::move( value );
+	}
+};
+
+// true once a slot returns a value that converts to true; the remaining
+// slots are not run
+template<class T>
+class any_of
+{
+	bool handled = false;
+
+public:
+	using result_type = bool;
+
+	bool operator()( T v )
+	{
+		handled = static_cast<bool>( v );
+		return !handled;
+	}
+
+	result_type result() const
+	{
+		return handled;
+	}
+};
+
+// The first result that converts to true (a non-null pointer, an engaged
+// handle), or a default constructed T if there is none
+template<class T>
+class first_non_null
+{
+	T value{};
+
+public:
+	using result_type = T;
+
+	bool operator()( T v )
+	{
+		if ( !static_cast<bool>( v ) )
+			return true;
+
+		value = std::move( v );
+		return false;
+	}
+
+	result_type result()
+	{
+		return std::move( value );
+	}
+};
+
+template<class T, class Reducer>
+class fold_combiner
+{
+	T value;
+	Reducer reducer;
+
+public:
+	using result_type = T;
+
+	fold_combiner( T init, Reducer r )
+		: value( std::move( init ) ), reducer( std::move( r ) )
+	{}
+
+	template<class R>
+	bool operator()( R&& v )
+	{
+		value = reducer( std::move( value ), std::forward<R>(v) );
+		return true;
+	}
+
+	result_type result()
+	{
+		return std::move( value );
+	}
+};
+
+template<class T, class Reducer>
+fold_combiner<T, Reducer> fold( T init, Reducer reducer )
+{
+	return fold_combiner<T, Reducer>( std::move( init ), std::move( reducer ) );
+}
+
+template<class T, class = void>
+struct is_combiner
+	: std::false_type
+{};
+
+template<class T>
+struct is_combiner< T, decltype( void( std::declval<T&>().result() ) ) >
+	: std::true_type
+{};
+
+} // namespace pac
+
+#endif // PAC_COMBINER_HPP
@@ -0,0 +1,189 @@
+/*
+ * This file is part of PAC
+ *
+ * PAC is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * PAC is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with PAC.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef PAC_CONFLATE_HPP
+#define PAC_CONFLATE_HPP
+
+#include <memory>
+#include <mutex>
+#include <tuple>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "apply.hpp"
+#include "callback.hpp"
+#include "context.hpp"
+
+namespace pac {
+
+// Shared by a conflating callback and the delivery it has posted to the
+// toe.  Values are kept per key, in the order the keys were first seen
+// since the last delivery; a newer value replaces the pending one
+template<class Key, class... Args>
+struct conflate_state
+{
+	using value_type = std::tuple< typename std::decay<Args>::type... >;
+	using entry_type = std::pair<Key, value_type>;
+
+	std::mutex mutex;
+	bool scheduled = false;
+
+	std::vector<entry_type> entries;
+	std::unordered_map<Key, std::size_t> index;
+
+	// Only touched by the toe; swapped with entries so both keep their
+	// capacity
+	std::vector<entry_type> delivering;
+
+	callback<void(Args...)> target;
+
+	conflate_state( callback<void(Args...)> cb )
+		: target( std::move( cb ) )
+	{}
+
+	// Returns true if a delivery has to be posted
+	template<class... A>
+	bool store( Key const& key, A&&... args )
+	{
+		std::lock_guard<std::mutex> lock( mutex );
+
+		auto found = index.find( key );
+		if ( found != index.end() ) {
+			entries[found->second].second = value_type( std::forward<A>(args)... );
+		} else {
+			index.emplace( key, entries.size() );
+			entries.emplace_back( key, value_type( std::forward<A>(args)... ) );
+		}
+
+		if ( scheduled )
+			return false;
+
+		scheduled = true;
+		return true;
+	}
+
+	void deliver()
+	{
+		{
+			std::lock_guard<std::mutex> lock( mutex );
+			std::swap( entries, delivering );
+			index.clear();
+			scheduled = false;
+		}
+
+		for ( auto& entry : delivering )
+			pac::apply( target, std::move( entry.second ) );
+
+		delivering.clear();
+	}
+};
+
+// Without a key there is at most one pending value
+template<class... Args>
+struct conflate_state<void, Args...>
+{
+	using value_type = std::tuple< typename std::decay<Args>::type... >;
+
+	std::mutex mutex;
+	bool scheduled = false;
+
+	// Holds zero or one value; a vector so no value is needed up front
+	std::vector<value_type> latest;
+	std::vector<value_type> delivering;
+
+	callback<void(Args...)> target;
+
+	conflate_state( callback<void(Args...)> cb )
+		: target( std::move( cb ) )
+	{
+		latest.reserve( 1 );
+		delivering.reserve( 1 );
+	}
+
+	template<class... A>
+	bool store( A&&... args )
+	{
+		std::lock_guard<std::mutex> lock( mutex );
+
+		if ( latest.empty() )
+			latest.emplace_back( std::forward<A>(args)... );
+		else
+			latest.front() = value_type( std::forward<A>(args)... );
+
+		if ( scheduled )
+			return false;
+
+		scheduled = true;
+		return true;
+	}
+
+	void deliver()
+	{
+		{
+			std::lock_guard<std::mutex> lock( mutex );
+			std::swap( latest, delivering );
+			scheduled = false;
+		}
+
+		if ( !delivering.empty() )
+			pac::apply( target, std::move( delivering.front() ) );
+
+		delivering.clear();
+	}
+};
+
+// Callback delivering cb on toe with only the newest value emitted since
+// the last delivery.  However fast it is called, at most one delivery is
+// queued on toe at a time.  Like toe_callback, toe must outlive it
+template<class... Args>
+callback<void(Args...)> conflate( toe& toe, callback<void(Args...)> cb )
+{
+	auto state = std::make_shared< conflate_state<void, Args...> >( std::move( cb ) );
+
+	return [&toe, state]( Args... args )
+	{
+		if ( state->store( std::forward<Args>(args)... ) )
+			toe.add_callback( [state]() { state->deliver(); } );
+	};
+}
+
+// As conflate, keeping the newest value per key_of( args... ); a delivery
+// hands every pending key to cb in the order they were first emitted
+template<class KeyFunc, class... Args>
+callback<void(Args...)> conflate_by_key( toe& toe, KeyFunc key_of,
+                                         callback<void(Args...)> cb )
+{
+	using key_type = typename std::decay<
+		decltype( key_of( std::declval<Args&>()... ) ) >::type;
+
+	auto state = std::make_shared< conflate_state<key_type, Args...> >( std::move( cb ) );
+
+	return [&toe, state, key_of]( Args... args ) mutable
+	{
+		auto key = key_of( args... );
+
+		if ( state->store( key, std::forward<Args>(args)... ) )
+			toe.add_callback( [state]() { state->deliver(); } );
+	};
+}
+
+} // namespace pac
+
+#endif // PAC_CONFLATE_HPP
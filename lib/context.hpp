@@ -29,7 +29,9 @@
 
 #include "runnable.hpp"
 #include "signal.hpp"
+#include "memory-resource.hpp"
 
+#include <chrono>
 #include <memory>
 #include <thread>
 #include <condition_variable>
@@ -45,23 +47,42 @@ namespace pac {
 class context
 {
 public:
-	using runnable_ptr = std::shared_ptr< runnable >;
-	using runnable_cont = std::list< runnable_ptr >;
+	using runnable_cont = std::list< runnable, polymorphic_allocator<runnable> >;
 	using runnable_iter = typename runnable_cont::iterator;
 
+	using clock_type = std::chrono::steady_clock;
+	using time_point = clock_type::time_point;
+	using timer_cont = std::multimap<
+		time_point, runnable, std::less<time_point>,
+		polymorphic_allocator< std::pair<const time_point, runnable> > >;
+
 	using context_id = std::size_t;
 	using context_ptr = std::shared_ptr< context >;
 
 	using thread_id = std::thread::id;
 
 private:
+	memory_resource *resource;
 	runnable_cont runnables;
+
+	// Runnables waiting for their deadline, earliest first; they join
+	// runnables once it has passed
+	timer_cont timers;
+
 	context_id cid;
 	thread_id tid;
 
 public:
 	context()
-		: runnables{}, cid{}, tid{}
+		: context( get_default_resource() )
+	{}
+
+	// Queue nodes and runnables added through add_callback are allocated
+	// from res
+	explicit context( memory_resource *res )
+		: resource{ res }, runnables( polymorphic_allocator<runnable>( res ) ),
+		  timers( typename timer_cont::allocator_type( res ) ),
+		  cid{}, tid{}
 	{}
 
 	static context_ptr create()
@@ -69,12 +90,25 @@ public:
 		return std::make_shared<context>();
 	}
 
-	runnable_ptr next_runnable()
+	static context_ptr create( memory_resource *res )
+	{
+		return std::make_shared<context>( res );
+	}
+
+	memory_resource *get_memory_resource() const
+	{
+		return resource;
+	}
+
+	runnable next_runnable()
 	{
+		if ( !timers.empty() )
+			expire_timers( clock_type::now() );
+
 		if ( runnables.empty() )
 			return {};
 
-		auto run = runnables.front();
+		auto run = std::move( runnables.front() );
 		runnables.pop_front();
 
 		return run;
@@ -85,24 +119,63 @@ public:
 		return runnables.size();
 	}
 
-	void add_runnable( runnable_ptr run )
+	void add_runnable( runnable run )
 	{
-		runnables.push_back( run );
+		runnables.push_back( std::move( run ) );
 	}
 
 	template<class Callback, class... Args>
 	void add_callback( Callback callback, Args&&... args )
 	{
-		runnable_ptr run =
-			std::make_shared<runnable>( callback, std::forward<Args>(args)... );
+		runnables.emplace_back( std::allocator_arg, resource,
+		                        std::move( callback ),
+		                        std::forward<Args>(args)... );
+		runnables.back().set_once();
+	}
+
+	// Run callback once deadline has passed
+	template<class Callback, class... Args>
+	void add_timeout( time_point deadline, Callback callback, Args&&... args )
+	{
+		runnable run( std::allocator_arg, resource, std::move( callback ),
+		              std::forward<Args>(args)... );
+		run.set_once();
+
+		timers.emplace( deadline, std::move( run ) );
+	}
+
+	std::size_t timer_count()
+	{
+		return timers.size();
+	}
+
+	// The earliest timer deadline, or limit if that comes first
+	time_point next_deadline( time_point limit )
+	{
+		if ( timers.empty() || limit < timers.begin()->first )
+			return limit;
+
+		return timers.begin()->first;
+	}
+
+	bool has_due_timer( time_point now )
+	{
+		return !timers.empty() && timers.begin()->first <= now;
+	}
 
-		run->set_once();
-		add_runnable( run );
+	// Queue the timers whose deadline has passed, in deadline order
+	void expire_timers( time_point now )
+	{
+		while ( has_due_timer( now ) ) {
+			runnables.push_back( std::move( timers.begin()->second ) );
+			timers.erase( timers.begin() );
+		}
 	}
 
 	void reset()
 	{
 		runnables.clear();
+		timers.clear();
 	}
 
 	void set_thread_id( thread_id id )
@@ -147,11 +220,11 @@ struct context_invoker
 		if (!nextrun)
 			return false;
 
-		auto res = nextrun->run();
+		auto res = nextrun.run();
 
 		if ( res == runnable_status::CONTINUING ) {
 			lock.lock();
-			ctxt->add_runnable( nextrun );
+			ctxt->add_runnable( std::move( nextrun ) );
 			lock.unlock();
 		}
 
@@ -187,7 +260,11 @@ private:
 
 			auto res = inv.iterate(mutex);
 			if ( !res ) {
-				idle( [&](){ return !quitme && ctxt->runnable_count() == 0; } );
+				idle( [&]()
+				      {
+					      return !quitme && ctxt->runnable_count() == 0 &&
+						      !ctxt->has_due_timer( context::clock_type::now() );
+				      } );
 			}
 
 		}
@@ -206,11 +283,17 @@ private:
 		cond.wait_for( lock, std::chrono::milliseconds(10) );
 	}
 
+	// Sleep while pred holds, waking at least every 10ms and when the next
+	// timer is due; pred is checked with the queue locked
 	template<class Condition>
-	void idle( Condition cond )
+	void idle( Condition pred )
 	{
-		while( cond() )
-			idle();
+		std::unique_lock<std::mutex> lock( mutex );
+
+		while ( pred() ) {
+			auto limit = context::clock_type::now() + std::chrono::milliseconds(10);
+			cond.wait_until( lock, ctxt->next_deadline( limit ) );
+		}
 	}
 
 	void wake()
@@ -306,7 +389,19 @@ public:
 	{
 		{
 			std::lock_guard<std::mutex> lock( mutex );
-			ctxt->add_callback( callback, std::forward<Args>(args)... );
+			ctxt->add_callback( std::move( callback ), std::forward<Args>(args)... );
+		}
+		wake();
+	}
+
+	template<class Callback, class... Args>
+	void add_timeout( long long time_us, Callback callback, Args&&... args )
+	{
+		{
+			std::lock_guard<std::mutex> lock( mutex );
+			ctxt->add_timeout( context::clock_type::now() +
+			                   std::chrono::microseconds( time_us ),
+			                   std::move( callback ), std::forward<Args>(args)... );
 		}
 		wake();
 	}
@@ -326,6 +421,11 @@ public:
 		: impl( std::make_shared<toe_impl>() )
 	{}
 
+	// Tasks posted to this toe are allocated from res
+	explicit toe( memory_resource *res )
+		: impl( std::make_shared<toe_impl>( context::create( res ) ) )
+	{}
+
 	toe( context_ptr c )
 		: impl( std::make_shared<toe_impl>( c ) )
 	{}
@@ -375,7 +475,15 @@ public:
 	template<class Callback, class... Args>
 	void add_callback( Callback callback, Args&&... args )
 	{
-		impl->add_callback( callback, std::forward<Args>(args)... );
+		impl->add_callback( std::move( callback ), std::forward<Args>(args)... );
+	}
+
+	// Run callback on this toe once time_us microseconds have passed
+	template<class Callback, class... Args>
+	void add_timeout( long long time_us, Callback callback, Args&&... args )
+	{
+		impl->add_timeout( time_us, std::move( callback ),
+		                   std::forward<Args>(args)... );
 	}
 
 };
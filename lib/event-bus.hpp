@@ -0,0 +1,154 @@
+/*
+ * This file is part of PAC
+ *
+ * PAC is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * PAC is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with PAC.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef PAC_EVENT_BUS_HPP
+#define PAC_EVENT_BUS_HPP
+
+#include <atomic>
+#include <memory>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "callback.hpp"
+#include "context.hpp"
+#include "memory-resource.hpp"
+#include "signal.hpp"
+
+namespace pac {
+
+inline std::size_t next_event_index()
+{
+	static std::atomic<std::size_t> counter{ 0 };
+	return counter++;
+}
+
+// Dense index of an event type, assigned the first time the type is used
+// and then read from a function local static; no RTTI is involved
+template<class Event>
+std::size_t event_index()
+{
+	static const std::size_t index = next_event_index();
+	return index;
+}
+
+// Routes plain struct events to the subscribers of their type.  Each
+// event type has its own signal<void(Event const&)>, found by indexing a
+// vector with event_index<Event>().  Like signal, a bus is used from one
+// thread; subscribe_on hands events over to the subscriber's toe
+class event_bus
+{
+	struct channel_base
+	{
+		virtual ~channel_base() = default;
+	};
+
+	template<class Event>
+	struct channel : channel_base
+	{
+		signal<void(Event const&)> sig;
+
+		explicit channel( memory_resource *res )
+			: sig( res )
+		{}
+	};
+
+	memory_resource *resource;
+	std::vector< std::shared_ptr<channel_base>,
+	             polymorphic_allocator< std::shared_ptr<channel_base> > > channels;
+
+public:
+	event_bus()
+		: event_bus( get_default_resource() )
+	{}
+
+	explicit event_bus( memory_resource *res )
+		: resource( res ),
+		  channels( polymorphic_allocator< std::shared_ptr<channel_base> >( res ) )
+	{}
+
+	event_bus( event_bus const& ) = delete;
+	event_bus& operator=( event_bus const& ) = delete;
+
+	// Subscribe to Event with anything signal::connect accepts
+	template<class Event, class... T>
+	connection subscribe( T&&... t )
+	{
+		return events<Event>().connect( std::forward<T>(t)... );
+	}
+
+	// Subscribe func to Event, called on toe with a copy of the event; toe
+	// must outlive the subscription.  func is shared with the runs posted
+	// to toe rather than copied into each, and may be released on either
+	// thread, so it comes from the global heap instead of the bus's
+	// resource
+	template<class Event, class Func>
+	connection subscribe_on( toe& toe, Func func )
+	{
+		auto receiver = std::make_shared< callback<void(Event const&)> >( std::move( func ) );
+
+		return events<Event>().connect(
+			[&toe, receiver]( Event const& event )
+			{
+				toe.add_callback( [receiver, event]() { ( *receiver )( event ); } );
+			} );
+	}
+
+	template<class Event>
+	void publish( Event const& event )
+	{
+		auto index = event_index<Event>();
+
+		if ( index < channels.size() && channels[index] )
+			static_cast<channel<Event> *>( channels[index].get() )->sig.emit( event );
+	}
+
+	template<class Event>
+	std::size_t subscriber_count()
+	{
+		auto index = event_index<Event>();
+
+		if ( index < channels.size() && channels[index] )
+			return static_cast<channel<Event> *>( channels[index].get() )->sig.slot_count();
+
+		return 0;
+	}
+
+	// The signal carrying Event, created on first use
+	template<class Event>
+	signal<void(Event const&)>& events()
+	{
+		static_assert( std::is_same< Event, typename std::decay<Event>::type >::value,
+		               "events are subscribed to by their plain type" );
+
+		auto index = event_index<Event>();
+
+		if ( index >= channels.size() )
+			channels.resize( index + 1 );
+
+		if ( !channels[index] )
+			channels[index] = std::allocate_shared< channel<Event> >(
+				polymorphic_allocator< channel<Event> >( resource ), resource );
+
+		return static_cast<channel<Event> *>( channels[index].get() )->sig;
+	}
+};
+
+} // namespace pac
+
+#endif // PAC_EVENT_BUS_HPP
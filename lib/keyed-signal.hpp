@@ -0,0 +1,231 @@
+/*
+ * This file is part of PAC
+ *
+ * PAC is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * PAC is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with PAC.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef PAC_KEYED_SIGNAL_HPP
+#define PAC_KEYED_SIGNAL_HPP
+
+#include <functional>
+#include <tuple>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+
+#include "memory-resource.hpp"
+#include "signal.hpp"
+
+namespace pac {
+
+template< class Key, class Signature, class Hash = std::hash<Key> >
+class keyed_signal;
+
+// A signal per key: emit( key, args... ) only reaches the slots connected
+// to that key, plus the wildcard slots connected with connect_any, which
+// are also handed the key.  Channels are created on first connection and
+// dropped once all of their slots are disconnected: emitting to a key drops
+// its channel if it has become empty, and connecting sweeps out every empty
+// channel once the map has doubled since the last sweep, so churning keys
+// does not accumulate channels
+template<class Key, class Ret, class... Args, class Hash>
+class keyed_signal<Key, Ret(Args...), Hash>
+{
+public:
+	using signal_type = signal<Ret(Args...)>;
+	using wildcard_signal_type = signal<Ret(Key const&, Args...)>;
+	using results_type = typename signal_type::results_type;
+
+private:
+	using channel_map = std::unordered_map<
+		Key, signal_type, Hash, std::equal_to<Key>,
+		polymorphic_allocator< std::pair<const Key, signal_type> > >;
+
+	static constexpr std::size_t min_sweep = 16;
+
+	memory_resource *resource;
+	channel_map channels;
+	wildcard_signal_type wildcard;
+
+	// Channels are only dropped outside of emissions, since a slot may be
+	// running on the one being dropped
+	std::size_t dispatch_depth = 0;
+	std::size_t sweep_at = min_sweep;
+
+	struct emission_scope
+	{
+		std::size_t& depth;
+
+		explicit emission_scope( std::size_t& d )
+			: depth( d )
+		{
+			++depth;
+		}
+
+		~emission_scope()
+		{
+			--depth;
+		}
+	};
+
+public:
+	keyed_signal()
+		: keyed_signal( get_default_resource() )
+	{}
+
+	explicit keyed_signal( memory_resource *res )
+		: resource( res ),
+		  channels( 0, Hash(), std::equal_to<Key>(),
+		            typename channel_map::allocator_type( res ) ),
+		  wildcard( res )
+	{}
+
+	keyed_signal(keyed_signal const&) = delete;
+	keyed_signal& operator=(keyed_signal const&) = delete;
+
+	template<class... T>
+	connection connect( Key const& key, T&&... t )
+	{
+		return channel( key ).connect( std::forward<T>(t)... );
+	}
+
+	// Connect a slot called for every key, with the key as first argument
+	template<class... T>
+	connection connect_any( T&&... t )
+	{
+		return wildcard.connect( std::forward<T>(t)... );
+	}
+
+	template<class... A>
+	results_type emit( Key const& key, A&&... args )
+	{
+		return emit_impl( std::is_void<Ret>(), key, std::forward<A>(args)... );
+	}
+
+	std::size_t slot_count( Key const& key ) const
+	{
+		auto found = channels.find( key );
+		if ( found == channels.end() )
+			return 0;
+
+		return found->second.slot_count();
+	}
+
+	std::size_t wildcard_count() const
+	{
+		return wildcard.slot_count();
+	}
+
+	std::size_t channel_count() const
+	{
+		return channels.size();
+	}
+
+	// Drop every channel without slots; does nothing while emitting
+	void compact()
+	{
+		if ( dispatch_depth > 0 )
+			return;
+
+		for ( auto it = channels.begin(); it != channels.end(); ) {
+			if ( it->second.slot_count() == 0 )
+				it = channels.erase( it );
+			else
+				++it;
+		}
+
+		sweep_at = channels.size() * 2;
+		if ( sweep_at < min_sweep )
+			sweep_at = min_sweep;
+	}
+
+private:
+	signal_type& channel( Key const& key )
+	{
+		auto found = channels.find( key );
+		if ( found != channels.end() )
+			return found->second;
+
+		if ( channels.size() >= sweep_at )
+			compact();
+
+		return channels.emplace( std::piecewise_construct,
+		                         std::forward_as_tuple( key ),
+		                         std::forward_as_tuple( resource ) ).first->second;
+	}
+
+	// Keyed slots run before the wildcard ones; arguments are passed on
+	// as lvalues since both sets of slots see them
+	template<class... A>
+	void emit_impl( std::true_type, Key const& key, A&&... args )
+	{
+		signal_type *sig = find_channel( key );
+
+		{
+			emission_scope scope( dispatch_depth );
+
+			if ( sig )
+				sig->emit( args... );
+
+			if ( wildcard.slot_count() )
+				wildcard.emit( key, args... );
+		}
+
+		drop_if_empty( key, sig );
+	}
+
+	template<class... A>
+	results_type emit_impl( std::false_type, Key const& key, A&&... args )
+	{
+		results_type results;
+		signal_type *sig = find_channel( key );
+
+		{
+			emission_scope scope( dispatch_depth );
+
+			if ( sig )
+				results = sig->emit( args... );
+
+			if ( wildcard.slot_count() ) {
+				auto any = wildcard.emit( key, args... );
+				results.insert( results.end(),
+				                std::make_move_iterator( any.begin() ),
+				                std::make_move_iterator( any.end() ) );
+			}
+		}
+
+		drop_if_empty( key, sig );
+
+		return results;
+	}
+
+	// Slots may connect to other keys while emitting; that can rehash the
+	// map, but the channel itself stays where it is
+	signal_type *find_channel( Key const& key )
+	{
+		auto found = channels.find( key );
+		return found != channels.end() ? &found->second : nullptr;
+	}
+
+	void drop_if_empty( Key const& key, signal_type *sig )
+	{
+		if ( sig && dispatch_depth == 0 && sig->slot_count() == 0 )
+			channels.erase( key );
+	}
+};
+
+} // namespace pac
+
+#endif // PAC_KEYED_SIGNAL_HPP
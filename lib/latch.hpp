@@ -0,0 +1,61 @@
+/*
+ * This file is part of PAC
+ *
+ * PAC is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * PAC is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with PAC.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef PAC_LATCH_HPP
+#define PAC_LATCH_HPP
+
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+
+namespace pac {
+
+// Single use countdown; wait() returns once count_down() has been called
+// the given number of times.  A subset of C++20 std::latch
+class latch
+{
+	std::mutex mutex;
+	std::condition_variable cond;
+	std::size_t count;
+
+public:
+	explicit latch( std::size_t n )
+		: count( n )
+	{}
+
+	latch( latch const& ) = delete;
+	latch& operator=( latch const& ) = delete;
+
+	void count_down()
+	{
+		std::lock_guard<std::mutex> lock( mutex );
+
+		if ( --count == 0 )
+			cond.notify_all();
+	}
+
+	void wait()
+	{
+		std::unique_lock<std::mutex> lock( mutex );
+		cond.wait( lock, [this]() { return count == 0; } );
+	}
+};
+
+} // namespace pac
+
+#endif // PAC_LATCH_HPP
@@ -0,0 +1,187 @@
+/*
+ * This file is part of PAC
+ *
+ * PAC is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * PAC is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with PAC.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef PAC_MEMOIZE_HPP
+#define PAC_MEMOIZE_HPP
+
+#include <functional>
+#include <list>
+#include <memory>
+#include <tuple>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+
+#include "callback.hpp"
+#include "memory-resource.hpp"
+#include "sequence.hpp"
+
+namespace pac {
+
+template<class Signature>
+class memoized;
+
+// Callable caching the results of a pure function in a bounded LRU cache
+// keyed on its (hashed) arguments.  Copies share the cache, so a memoized
+// can be handed to a signal as a slot and still be queried for hit/miss
+// counts.  The cache is not synchronized; use it from a single toe
+template<class Ret, class... Args>
+class memoized< Ret(Args...) >
+{
+	static_assert( !std::is_void<Ret>::value,
+	               "memoizing a function without a result is pointless" );
+
+	using key_type = std::tuple< typename std::decay<Args>::type... >;
+	using key_ref = std::reference_wrapper<key_type const>;
+	using entry_type = std::pair<key_type, Ret>;
+	using entry_list = std::list< entry_type, polymorphic_allocator<entry_type> >;
+	using entry_iter = typename entry_list::iterator;
+
+	struct key_hash
+	{
+		template<std::size_t... Indices>
+		static std::size_t combine( key_type const& key,
+		                            index_sequence<Indices...> )
+		{
+			std::size_t seed = 0;
+			std::size_t hashes[] = {
+				0, std::hash< typename std::tuple_element<Indices, key_type>::type >()(
+					std::get<Indices>( key ) )...
+			};
+
+			for ( auto h : hashes )
+				seed ^= h + 0x9e3779b9 + ( seed << 6 ) + ( seed >> 2 );
+
+			return seed;
+		}
+
+		std::size_t operator()( key_ref key ) const
+		{
+			return combine( key.get(),
+			                typename make_sequence<sizeof...(Args)>::type() );
+		}
+	};
+
+	struct key_equal
+	{
+		bool operator()( key_ref a, key_ref b ) const
+		{
+			return a.get() == b.get();
+		}
+	};
+
+	using index_type = std::unordered_map<
+		key_ref, entry_iter, key_hash, key_equal,
+		polymorphic_allocator< std::pair<key_ref const, entry_iter> > >;
+
+	struct state
+	{
+		callback<Ret(Args...)> func;
+		std::size_t capacity;
+
+		// most recently used first; the index refers to keys in place
+		entry_list entries;
+		index_type index;
+
+		std::size_t hits = 0;
+		std::size_t misses = 0;
+
+		state( callback<Ret(Args...)> f, std::size_t cap, memory_resource *res )
+			: func( std::move( f ) ), capacity( cap ),
+			  entries( polymorphic_allocator<entry_type>( res ) ),
+			  index( 0, key_hash(), key_equal(),
+			         typename index_type::allocator_type( res ) )
+		{}
+	};
+
+	std::shared_ptr<state> st;
+
+public:
+	memoized( callback<Ret(Args...)> func, std::size_t capacity,
+	          memory_resource *res = get_default_resource() )
+		: st( std::allocate_shared<state>( polymorphic_allocator<state>( res ),
+		                                   std::move( func ), capacity, res ) )
+	{}
+
+	Ret operator()(Args... args)
+	{
+		key_type key( args... );
+
+		auto found = st->index.find( std::cref( key ) );
+		if ( found != st->index.end() ) {
+			++st->hits;
+			st->entries.splice( st->entries.begin(), st->entries, found->second );
+			return found->second->second;
+		}
+
+		++st->misses;
+		Ret result = st->func( std::forward<Args>(args)... );
+
+		if ( st->capacity == 0 )
+			return result;
+
+		if ( st->entries.size() == st->capacity ) {
+			st->index.erase( std::cref( st->entries.back().first ) );
+			st->entries.pop_back();
+		}
+
+		st->entries.emplace_front( std::move( key ), result );
+		st->index.emplace( std::cref( st->entries.front().first ),
+		                   st->entries.begin() );
+
+		return result;
+	}
+
+	std::size_t hits() const
+	{
+		return st->hits;
+	}
+
+	std::size_t misses() const
+	{
+		return st->misses;
+	}
+
+	std::size_t size() const
+	{
+		return st->entries.size();
+	}
+
+	std::size_t capacity() const
+	{
+		return st->capacity;
+	}
+
+	void clear()
+	{
+		st->index.clear();
+		st->entries.clear();
+	}
+};
+
+template<class Ret, class... Args>
+memoized< Ret(Args...) > memoize( callback<Ret(Args...)> func,
+                                  std::size_t capacity,
+                                  memory_resource *res = get_default_resource() )
+{
+	return memoized< Ret(Args...) >( std::move( func ), capacity, res );
+}
+
+} // namespace pac
+
+#endif // PAC_MEMOIZE_HPP
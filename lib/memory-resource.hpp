@@ -0,0 +1,476 @@
+/*
+ * This file is part of PAC
+ *
+ * PAC is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * PAC is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with PAC.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef PAC_MEMORY_RESOURCE_HPP
+#define PAC_MEMORY_RESOURCE_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <utility>
+#include <vector>
+
+// Polymorphic memory resources modelled on C++17's std::pmr so PAC's
+// dynamic storage (callbacks, slots, runnables, context queues) can be
+// served from arenas and pools instead of the global heap
+
+namespace pac {
+
+class memory_resource
+{
+public:
+	virtual ~memory_resource() = default;
+
+	void *allocate( std::size_t bytes,
+	                std::size_t alignment = alignof(std::max_align_t) )
+	{
+		return do_allocate( bytes, alignment );
+	}
+
+	void deallocate( void *p, std::size_t bytes,
+	                 std::size_t alignment = alignof(std::max_align_t) )
+	{
+		do_deallocate( p, bytes, alignment );
+	}
+
+	bool is_equal( memory_resource const& other ) const noexcept
+	{
+		return do_is_equal( other );
+	}
+
+private:
+	virtual void *do_allocate( std::size_t bytes, std::size_t alignment ) = 0;
+	virtual void do_deallocate( void *p, std::size_t bytes,
+	                            std::size_t alignment ) = 0;
+
+	virtual bool do_is_equal( memory_resource const& other ) const noexcept
+	{
+		return this == &other;
+	}
+};
+
+inline bool operator==( memory_resource const& a, memory_resource const& b )
+{
+	return &a == &b || a.is_equal( b );
+}
+
+inline bool operator!=( memory_resource const& a, memory_resource const& b )
+{
+	return !( a == b );
+}
+
+class new_delete_resource_impl : public memory_resource
+{
+	void *do_allocate( std::size_t bytes, std::size_t )
+	{
+		return ::operator new( bytes );
+	}
+
+	void do_deallocate( void *p, std::size_t, std::size_t )
+	{
+		::operator delete( p );
+	}
+};
+
+inline memory_resource *new_delete_resource()
+{
+	static new_delete_resource_impl res;
+	return &res;
+}
+
+// Resource that always fails; useful as the upstream of an arena that must
+// never touch the global heap
+class null_memory_resource_impl : public memory_resource
+{
+	void *do_allocate( std::size_t, std::size_t )
+	{
+		throw std::bad_alloc();
+	}
+
+	void do_deallocate( void *, std::size_t, std::size_t )
+	{}
+};
+
+inline memory_resource *null_memory_resource()
+{
+	static null_memory_resource_impl res;
+	return &res;
+}
+
+inline std::atomic<memory_resource *>& default_resource_ref()
+{
+	static std::atomic<memory_resource *> res{ new_delete_resource() };
+	return res;
+}
+
+inline memory_resource *get_default_resource()
+{
+	return default_resource_ref().load();
+}
+
+inline memory_resource *set_default_resource( memory_resource *res )
+{
+	if ( !res )
+		res = new_delete_resource();
+
+	return default_resource_ref().exchange( res );
+}
+
+// Bump allocator over an initial buffer; deallocation is a no-op and all
+// memory is returned at once by release() or destruction.  Once the buffer
+// is exhausted further chunks come from the upstream resource
+class monotonic_buffer_resource : public memory_resource
+{
+	struct chunk
+	{
+		chunk *next;
+		std::size_t size;
+	};
+
+	memory_resource *upstream;
+	char *cur;
+	std::size_t left;
+	std::size_t next_size;
+	chunk *chunks;
+
+	void *do_allocate( std::size_t bytes, std::size_t alignment )
+	{
+		void *p = cur;
+		if ( !std::align( alignment, bytes, p, left ) ) {
+			grow( bytes + alignment );
+			p = cur;
+			std::align( alignment, bytes, p, left );
+		}
+
+		cur = static_cast<char *>( p ) + bytes;
+		left -= bytes;
+		return p;
+	}
+
+	void do_deallocate( void *, std::size_t, std::size_t )
+	{}
+
+	void grow( std::size_t min_bytes )
+	{
+		std::size_t size = next_size;
+		while ( size < min_bytes + sizeof(chunk) )
+			size *= 2;
+
+		auto c = static_cast<chunk *>( upstream->allocate( size ) );
+		c->next = chunks;
+		c->size = size;
+		chunks = c;
+
+		cur = reinterpret_cast<char *>( c + 1 );
+		left = size - sizeof(chunk);
+		next_size = size * 2;
+	}
+
+public:
+	explicit monotonic_buffer_resource(
+		memory_resource *up = get_default_resource() )
+		: upstream( up ), cur( nullptr ), left( 0 ),
+		  next_size( 1024 ), chunks( nullptr )
+	{}
+
+	monotonic_buffer_resource( void *buffer, std::size_t size,
+	                           memory_resource *up = get_default_resource() )
+		: upstream( up ), cur( static_cast<char *>( buffer ) ), left( size ),
+		  next_size( size ? size * 2 : 1024 ), chunks( nullptr )
+	{}
+
+	monotonic_buffer_resource( monotonic_buffer_resource const& ) = delete;
+	monotonic_buffer_resource& operator=( monotonic_buffer_resource const& ) = delete;
+
+	~monotonic_buffer_resource()
+	{
+		release();
+	}
+
+	void release()
+	{
+		while ( chunks ) {
+			auto next = chunks->next;
+			upstream->deallocate( chunks, chunks->size );
+			chunks = next;
+		}
+
+		cur = nullptr;
+		left = 0;
+	}
+
+	memory_resource *upstream_resource() const
+	{
+		return upstream;
+	}
+};
+
+// Bump allocator over a buffer of Size bytes held inline, for containers
+// that usually stay tiny; whatever does not fit comes from upstream.  The
+// buffer starts over once everything allocated from it is returned
+template<std::size_t Size>
+class inline_buffer_resource : public memory_resource
+{
+	alignas(std::max_align_t) char buffer[Size];
+	std::size_t used = 0;
+	std::size_t live = 0;
+	memory_resource *upstream;
+
+	void *do_allocate( std::size_t bytes, std::size_t alignment )
+	{
+		void *p = buffer + used;
+		std::size_t left = Size - used;
+
+		if ( !std::align( alignment, bytes, p, left ) )
+			return upstream->allocate( bytes, alignment );
+
+		used = static_cast<char *>( p ) + bytes - buffer;
+		++live;
+		return p;
+	}
+
+	void do_deallocate( void *p, std::size_t bytes, std::size_t alignment )
+	{
+		auto c = static_cast<char *>( p );
+		std::less<char *> before;
+
+		if ( before( c, buffer ) || !before( c, buffer + Size ) ) {
+			upstream->deallocate( p, bytes, alignment );
+			return;
+		}
+
+		if ( --live == 0 )
+			used = 0;
+	}
+
+public:
+	explicit inline_buffer_resource( memory_resource *up = get_default_resource() )
+		: upstream( up )
+	{}
+
+	inline_buffer_resource( inline_buffer_resource const& ) = delete;
+	inline_buffer_resource& operator=( inline_buffer_resource const& ) = delete;
+
+	memory_resource *upstream_resource() const
+	{
+		return upstream;
+	}
+};
+
+// Thread safe pool of power of two sized blocks for workloads that keep
+// allocating and freeing similar sized objects (e.g. a toe's task queue);
+// blocks larger than the biggest pool go straight to upstream
+class pool_resource : public memory_resource
+{
+	static const std::size_t min_block = sizeof(void *) * 2;
+	static const std::size_t max_block = 1024;
+	static const std::size_t pool_count = 7; // 16 .. 1024
+	static const std::size_t blocks_per_chunk = 32;
+
+	struct free_block
+	{
+		free_block *next;
+	};
+
+	memory_resource *upstream;
+	std::mutex mutex;
+	free_block *pools[pool_count];
+	std::vector<std::pair<void *, std::size_t>> chunks;
+
+	static std::size_t pool_index( std::size_t bytes )
+	{
+		std::size_t index = 0;
+		for ( std::size_t size = min_block; size < bytes; size *= 2 )
+			++index;
+		return index;
+	}
+
+	static std::size_t block_size( std::size_t index )
+	{
+		return min_block << index;
+	}
+
+	void *do_allocate( std::size_t bytes, std::size_t alignment )
+	{
+		if ( bytes > max_block || alignment > min_block )
+			return upstream->allocate( bytes, alignment );
+
+		auto index = pool_index( bytes );
+
+		std::lock_guard<std::mutex> lock( mutex );
+		if ( !pools[index] )
+			refill( index );
+
+		auto block = pools[index];
+		pools[index] = block->next;
+		return block;
+	}
+
+	void do_deallocate( void *p, std::size_t bytes, std::size_t alignment )
+	{
+		if ( bytes > max_block || alignment > min_block ) {
+			upstream->deallocate( p, bytes, alignment );
+			return;
+		}
+
+		auto index = pool_index( bytes );
+		auto block = static_cast<free_block *>( p );
+
+		std::lock_guard<std::mutex> lock( mutex );
+		block->next = pools[index];
+		pools[index] = block;
+	}
+
+	void refill( std::size_t index )
+	{
+		auto size = block_size( index );
+		auto bytes = size * blocks_per_chunk;
+		auto mem = static_cast<char *>( upstream->allocate( bytes, min_block ) );
+		chunks.emplace_back( mem, bytes );
+
+		for ( std::size_t i = 0; i < blocks_per_chunk; ++i ) {
+			auto block = reinterpret_cast<free_block *>( mem + i * size );
+			block->next = pools[index];
+			pools[index] = block;
+		}
+	}
+
+public:
+	explicit pool_resource( memory_resource *up = get_default_resource() )
+		: upstream( up ), mutex{}, pools{}, chunks{}
+	{}
+
+	pool_resource( pool_resource const& ) = delete;
+	pool_resource& operator=( pool_resource const& ) = delete;
+
+	~pool_resource()
+	{
+		release();
+	}
+
+	void release()
+	{
+		std::lock_guard<std::mutex> lock( mutex );
+		for ( auto& c : chunks )
+			upstream->deallocate( c.first, c.second, min_block );
+
+		chunks.clear();
+		for ( auto& p : pools )
+			p = nullptr;
+	}
+};
+
+// Standard allocator adaptor over a memory_resource
+template<class T>
+class polymorphic_allocator
+{
+	memory_resource *res;
+
+	template<class U>
+	friend class polymorphic_allocator;
+
+public:
+	using value_type = T;
+
+	polymorphic_allocator() noexcept
+		: res( get_default_resource() )
+	{}
+
+	polymorphic_allocator( memory_resource *r ) noexcept
+		: res( r ? r : get_default_resource() )
+	{}
+
+	template<class U>
+	polymorphic_allocator( polymorphic_allocator<U> const& other ) noexcept
+		: res( other.res )
+	{}
+
+	T *allocate( std::size_t n )
+	{
+		return static_cast<T *>( res->allocate( n * sizeof(T), alignof(T) ) );
+	}
+
+	void deallocate( T *p, std::size_t n )
+	{
+		res->deallocate( p, n * sizeof(T), alignof(T) );
+	}
+
+	memory_resource *resource() const noexcept
+	{
+		return res;
+	}
+
+	// Containers copied from one using an arena should not silently keep
+	// allocating from it
+	polymorphic_allocator select_on_container_copy_construction() const
+	{
+		return polymorphic_allocator();
+	}
+};
+
+template<class T, class U>
+bool operator==( polymorphic_allocator<T> const& a,
+                 polymorphic_allocator<U> const& b ) noexcept
+{
+	return *a.resource() == *b.resource();
+}
+
+template<class T, class U>
+bool operator!=( polymorphic_allocator<T> const& a,
+                 polymorphic_allocator<U> const& b ) noexcept
+{
+	return !( a == b );
+}
+
+// Deleter returning an object of exactly type T to its memory_resource
+template<class T>
+struct resource_delete
+{
+	memory_resource *resource;
+
+	void operator()( T *p ) const
+	{
+		p->~T();
+		resource->deallocate( p, sizeof(T), alignof(T) );
+	}
+};
+
+template<class T>
+using resource_unique_ptr = std::unique_ptr<T, resource_delete<T>>;
+
+template<class T, class... A>
+resource_unique_ptr<T> allocate_unique( memory_resource *res, A&&... args )
+{
+	void *mem = res->allocate( sizeof(T), alignof(T) );
+	try {
+		return resource_unique_ptr<T>(
+			::new (mem) T( std::forward<A>(args)... ),
+			resource_delete<T>{ res } );
+	}
+	catch (...) {
+		res->deallocate( mem, sizeof(T), alignof(T) );
+		throw;
+	}
+}
+
+} // namespace pac
+
+#endif // PAC_MEMORY_RESOURCE_HPP
@@ -0,0 +1,136 @@
+/*
+ * This file is part of PAC
+ *
+ * PAC is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * PAC is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with PAC.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef PAC_QUEUED_SIGNAL_HPP
+#define PAC_QUEUED_SIGNAL_HPP
+
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "memory-resource.hpp"
+#include "signal.hpp"
+
+namespace pac {
+
+template< class Signature >
+class queued_signal;
+
+// Signal whose emit only records its arguments; flush() delivers every
+// recorded emission to the slots in one slot-major pass (see
+// signal::emit_batch).  Call flush() when convenient: at the end of a
+// frame, or from a callback posted to the toe owning the receivers.
+// Results of non-void slots are discarded
+template<class Ret, class... Args>
+class queued_signal<Ret(Args...)>
+{
+public:
+	using signal_type = signal<Ret(Args...)>;
+
+	// Single argument emissions are queued as plain values so that batch
+	// receivers get them as one contiguous span
+	using value_type = typename std::conditional<
+		sizeof...(Args) == 1,
+		typename batch_traits<void(Args...)>::value_type,
+		std::tuple< typename std::decay<Args>::type... > >::type;
+
+private:
+	using queue_type = std::vector< value_type, polymorphic_allocator<value_type> >;
+
+	signal_type sig;
+
+	// Emissions land in queued; flush swaps it with delivering, so the
+	// values being delivered stay put while receivers emit again.  Both
+	// keep their capacity between flushes
+	queue_type queued;
+	queue_type delivering;
+	bool flushing = false;
+
+public:
+	explicit queued_signal( std::size_t capacity = 64,
+	                        memory_resource *res = get_default_resource() )
+		: sig( res ),
+		  queued( polymorphic_allocator<value_type>( res ) ),
+		  delivering( polymorphic_allocator<value_type>( res ) )
+	{
+		queued.reserve( capacity );
+		delivering.reserve( capacity );
+	}
+
+	queued_signal(queued_signal const&) = delete;
+	queued_signal& operator=(queued_signal const&) = delete;
+
+	template<class... T>
+	connection connect( T&&... t )
+	{
+		return sig.connect( std::forward<T>(t)... );
+	}
+
+	template<class Func>
+	connection connect_batch( Func func )
+	{
+		return sig.connect_batch( std::move( func ) );
+	}
+
+	template<class... A>
+	void emit( A&&... args )
+	{
+		queued.emplace_back( std::forward<A>(args)... );
+	}
+
+	// Deliver the emissions queued so far and return how many there were.
+	// Emissions made by receivers meanwhile wait for the next flush
+	std::size_t flush()
+	{
+		if ( flushing || queued.empty() )
+			return 0;
+
+		flushing = true;
+		std::swap( queued, delivering );
+
+		struct reset
+		{
+			queued_signal& qs;
+
+			~reset()
+			{
+				qs.delivering.clear();
+				qs.flushing = false;
+			}
+		} guard{ *this };
+
+		sig.emit_batch( delivering );
+
+		return delivering.size();
+	}
+
+	std::size_t pending() const
+	{
+		return queued.size();
+	}
+
+	signal_type& get_signal()
+	{
+		return sig;
+	}
+};
+
+} // namespace pac
+
+#endif // PAC_QUEUED_SIGNAL_HPP
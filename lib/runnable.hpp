@@ -31,9 +31,11 @@
 #include <tuple>
 #include <string>
 #include <map>
+#include <type_traits>
 
 #include "callback.hpp"
 #include "apply.hpp"
+#include "memory-resource.hpp"
 
 namespace pac {
 
@@ -87,7 +89,12 @@ class runnable
 	{
 		virtual ~runnable_concept() {}
 
-		virtual void operator()() = 0;
+		// consume is set when the runnable will not run again, letting the
+		// bound arguments be moved into the callback
+		virtual void operator()( bool consume ) = 0;
+
+		// Destroy and return the model to the resource it came from
+		virtual void destroy( memory_resource *res ) = 0;
 	};
 
 	template<class Callback, class... Args>
@@ -102,31 +109,89 @@ class runnable
 			, args( std::forward<A>(a)... )
 		{}
 
-		virtual void operator()()
+		virtual void operator()( bool consume )
+		{
+			if ( consume )
+				apply( cb, std::move( args ) );
+			else
+				apply( cb, args );
+		}
+
+		virtual void destroy( memory_resource *res )
 		{
-			apply( cb, args );
+			this->~runnable_model();
+			res->deallocate( this, sizeof(runnable_model),
+			                 alignof(runnable_model) );
 		}
 	};
 
-	std::shared_ptr< runnable_concept > rcon;
+	struct runnable_deleter
+	{
+		memory_resource *resource;
+
+		void operator()( runnable_concept *rc ) const
+		{
+			rc->destroy( resource );
+		}
+	};
+
+	using concept_ptr = std::unique_ptr< runnable_concept, runnable_deleter >;
+
+	template<class Model, class... A>
+	static concept_ptr make_model( memory_resource *res, A&&... a )
+	{
+		void *mem = res->allocate( sizeof(Model), alignof(Model) );
+		try {
+			return concept_ptr( ::new (mem) Model( std::forward<A>(a)... ),
+			                    runnable_deleter{ res } );
+		}
+		catch (...) {
+			res->deallocate( mem, sizeof(Model), alignof(Model) );
+			throw;
+		}
+	}
+
+	concept_ptr rcon;
 	runnable_context rctxt;
 
 public:
 	runnable()
-		: rcon{}
+		: rcon{ nullptr, runnable_deleter{ nullptr } }
 	{}
 
 	// Take Callback by value as it's a handle (pac::callback<>)
 	// Otherwise, type deduction will resolve to a lvalue ref, and a ref
 	// to a local stack callback could be kept dangling and invoked
-	// later
+	// later.  The callback is moved into the runnable so move-only
+	// callbacks (pac::unique_callback<>) can be queued as well
+	template<class Callback, class... Args,
+	         class = typename std::enable_if<
+		         !std::is_same<Callback, std::allocator_arg_t>::value >::type>
+	explicit runnable( Callback cb, Args&&... args )
+		: runnable( std::allocator_arg, get_default_resource(),
+		            std::move(cb), std::forward<Args>(args)... )
+	{}
+
+	// Allocate the callback and its bound arguments from res.  Arguments
+	// are stored decayed: this is where they are copied (or moved) once to
+	// cross over to the context that runs the callback
 	template<class Callback, class... Args>
-	runnable( Callback cb, Args&&... args )
-		: rcon( std::make_shared<runnable_model<Callback, Args...>>(
-			        cb, std::forward<Args>(args)...) ),
+	runnable( std::allocator_arg_t, memory_resource *res,
+	          Callback cb, Args&&... args )
+		: rcon( make_model< runnable_model<Callback,
+		                                   typename std::decay<Args>::type...> >(
+			        res, std::move(cb), std::forward<Args>(args)...) ),
 		  rctxt()
 	{}
 
+	runnable( runnable&& ) = default;
+	runnable& operator=( runnable&& ) = default;
+
+	explicit operator bool() const
+	{
+		return rcon != nullptr;
+	}
+
 	void set_once()
 	{
 		rctxt.once = true;
@@ -138,7 +203,7 @@ public:
 		if ( !rcon )
 			return runnable_status::INVALID;
 
-		(*rcon)();
+		(*rcon)( rctxt.once );
 
 		return rctxt.status;
 	}
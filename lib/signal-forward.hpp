@@ -50,10 +50,12 @@ struct forward_invoker
 			       std::move( newargs ) ) );
 	}
 
+	// Build the tuple type directly: make_tuple would decay (copy) reference
+	// arguments and leave a tuple of references dangling
 	template<class... InArgs>
 	static InFuncRet default_infunc( InArgs&&... inargs )
 	{
-		return std::make_tuple( std::forward<InArgs>( inargs )... );
+		return InFuncRet( std::forward<InArgs>( inargs )... );
 	}
 
 	template<class OR, class R>
@@ -190,16 +192,14 @@ struct forwarded_slot<
 	                              FOut fout)
 	{
 		pac::callback< OutRet( InArgs... ) > fwdcb =
-			[cb, fin, fout](InArgs... args)
+			[cb, fin, fout](InArgs... args) mutable
 			{
-				auto lcb = CB(cb);
-				auto lfin = FIn(fin);
-				auto lfout = FOut(fout);
-
 				forward_invoker< InRet, OutArgs... > invoker;
 
-				//std::cout << "Callback Firing !\n";
-				return invoker( lfin, lcb, lfout, args... );
+				// invoke the captured callbacks in place rather than
+				// copying them on every emission
+				return invoker( fin, cb, fout,
+				                std::forward<InArgs>( args )... );
 			};
 
 		return fwdcb;
@@ -247,15 +247,15 @@ template<class OrigSignal, class NewSignalSignature>
 class signal_forward_base;
 
 template<template<class...> class Signal,
-         class OrigRet, class... OrigArgs,
+         class OrigRet, class... OrigArgs, class... Extra,
          class Ret, class... Args>
 class signal_forward_base<
-         Signal<OrigRet(OrigArgs...)>,
+         Signal<OrigRet(OrigArgs...), Extra...>,
          Ret(Args...)
         >
 {
 protected:
-	using SignalType = Signal<OrigRet(OrigArgs...)>;
+	using SignalType = Signal<OrigRet(OrigArgs...), Extra...>;
 	using CallbackType = pac::callback<Ret( Args... )>;
 	using InvokerType = forward_invoker<std::tuple<Args...>,Ret>;
 
@@ -276,15 +276,15 @@ protected:
 };
 
 template<template<class...> class Signal,
-         class OrigRet, class... OrigArgs,
+         class OrigRet, class... OrigArgs, class... Extra,
          class... Args>
 class signal_forward_base<
-         Signal<OrigRet(OrigArgs...)>,
+         Signal<OrigRet(OrigArgs...), Extra...>,
          void(Args...)
         >
 {
 protected:
-	using SignalType = Signal<OrigRet(OrigArgs...)>;
+	using SignalType = Signal<OrigRet(OrigArgs...), Extra...>;
 	using CallbackType = pac::callback<void( Args... )> ;
 
 	SignalType& sig;
@@ -307,14 +307,14 @@ template<class...>
 struct sigfwd_gen;
 
 template<template<class...> class Signal,
-         class OrigRet, class... OrigArgs,
+         class OrigRet, class... OrigArgs, class... Extra,
          class Ret, class... Args>
 struct sigfwd_gen<
-         Signal<OrigRet(OrigArgs...)>,
+         Signal<OrigRet(OrigArgs...), Extra...>,
          Ret(Args...)
         >
 {
-	using SignalType = Signal<OrigRet(OrigArgs...)>;
+	using SignalType = Signal<OrigRet(OrigArgs...), Extra...>;
 	using CallbackType = pac::callback<Ret( Args... )>;
 	using InvokerType = forward_invoker<std::tuple<Args...>,Ret>;
 
@@ -326,38 +326,38 @@ struct sigfwd_gen<
 };
 
 template<template<class...> class Signal,
-         class OrigRet, class... OrigArgs,
+         class OrigRet, class... OrigArgs, class... Extra,
          class Ret, class... Args>
 typename sigfwd_gen<
-         Signal<OrigRet(OrigArgs...)>,
+         Signal<OrigRet(OrigArgs...), Extra...>,
          Ret(Args...)
         >::InFuncCallbackType
 sigfwd_gen<
-         Signal<OrigRet(OrigArgs...)>,
+         Signal<OrigRet(OrigArgs...), Extra...>,
          Ret(Args...)
         >::DefaultInFunc = &InvokerType::template default_infunc<OrigArgs...>;
 
 template<template<class...> class Signal,
-         class OrigRet, class... OrigArgs,
+         class OrigRet, class... OrigArgs, class... Extra,
          class Ret, class... Args>
 typename sigfwd_gen<
-         Signal<OrigRet(OrigArgs...)>,
+         Signal<OrigRet(OrigArgs...), Extra...>,
          Ret(Args...)
         >::OutFuncCallbackType
 sigfwd_gen<
-         Signal<OrigRet(OrigArgs...)>,
+         Signal<OrigRet(OrigArgs...), Extra...>,
          Ret(Args...)
         >::DefaultOutFunc = &InvokerType::template default_outfunc<OrigRet, Ret>;
 
 template<template<class...> class Signal,
-         class OrigRet, class... OrigArgs,
+         class OrigRet, class... OrigArgs, class... Extra,
          class... Args>
 struct sigfwd_gen<
-         Signal<OrigRet(OrigArgs...)>,
+         Signal<OrigRet(OrigArgs...), Extra...>,
          void(Args...)
         >
 {
-	using SignalType = Signal<OrigRet(OrigArgs...)>;
+	using SignalType = Signal<OrigRet(OrigArgs...), Extra...>;
 	using CallbackType = pac::callback<void( Args... )>;
 	using InvokerType = forward_invoker<void>;
 
@@ -377,24 +377,24 @@ struct sigfwd_gen<
 };
 
 template<template<class...> class Signal,
-         class OrigRet, class... OrigArgs,
+         class OrigRet, class... OrigArgs, class... Extra,
          class... Args>
 typename sigfwd_gen<
-         Signal<OrigRet(OrigArgs...)>,
+         Signal<OrigRet(OrigArgs...), Extra...>,
          void(Args...)
         >::InFuncCallbackType sigfwd_gen<
-         Signal<OrigRet(OrigArgs...)>,
+         Signal<OrigRet(OrigArgs...), Extra...>,
          void(Args...)
         >::DefaultInFunc = &InvokerType::default_infunc;
 
 template<template<class...> class Signal,
-         class OrigRet, class... OrigArgs,
+         class OrigRet, class... OrigArgs, class... Extra,
          class... Args>
 typename sigfwd_gen<
-         Signal<OrigRet(OrigArgs...)>,
+         Signal<OrigRet(OrigArgs...), Extra...>,
          void(Args...)
         >::OutFuncCallbackType sigfwd_gen<
-         Signal<OrigRet(OrigArgs...)>,
+         Signal<OrigRet(OrigArgs...), Extra...>,
          void(Args...)
         >::DefaultOutFunc = &InvokerType::template default_outfunc<OrigRet>;
 
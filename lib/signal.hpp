@@ -27,250 +27,1960 @@
 #ifndef SIGNAL_HPP
 #define SIGNAL_HPP
 
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <exception>
 #include <functional>
+#include <tuple>
 #include <vector>
-#include <unordered_map>
 #include <utility>
 #include <memory>
+#include <mutex>
+#include <new>
+#include <stdexcept>
 
 #include <iostream>
 
+#include "apply.hpp"
 #include "callback.hpp"
+#include "combiner.hpp"
+#include "latch.hpp"
+#include "memory-resource.hpp"
+#include "span.hpp"
 
 namespace pac {
 
-template< class Signature >
+// Threading policies for signal.  st_policy signals are used from one
+// thread at a time; mt_policy signals may be connected to, disconnected
+// from and emitted on from any number of threads
+struct st_policy
+{};
+
+struct mt_policy
+{};
+
+template< class Signature, class Policy = st_policy >
 class signal;
 
+enum class visit_result
+{
+	invoked,
+	skipped,
+	expired
+};
+
+// Flags shared by the slots of one connection_group, checked as they are
+// visited; atomic since a group may span mt_policy signals
+struct group_state
+{
+	std::atomic<bool> blocked{ false };
+	std::atomic<bool> disconnected{ false };
+};
+
 template<class Callback>
 struct slot
 {
 	bool blocked = false;
 	bool delete_requested = false;
+	bool tracked = false;
+
+	// Index of the receiver taking whole batches, if the slot has one
+	std::uint32_t batch_index = std::uint32_t(-1);
+
+	// Slots of higher priority run first
+	int priority = 0;
+
+	std::size_t id = 0;
 	Callback callback;
 
-	slot(Callback cb)
-		: callback(cb)
+	// Receiver the slot is bound to when tracked; the slot is only invoked
+	// while it is alive and is purged once it expires
+	std::weak_ptr<void> tracker;
+
+	// Group the slot was connected in, if any; a disconnected group's
+	// slots expire like those of a destroyed receiver
+	std::shared_ptr<group_state> group;
+
+	slot(Callback cb)
+		: callback( std::move( cb ) )
+	{}
+
+	slot(Callback cb, std::weak_ptr<void> track)
+		: tracked( true ), callback( std::move( cb ) ), tracker( std::move( track ) )
+	{}
+
+	slot( slot const& ) = default;
+	slot( slot&& ) = default;
+
+	slot& operator=( slot const& ) = default;
+	slot& operator=( slot&& ) = default;
+
+	// Invoke func with the callback unless the slot or its group is blocked
+	// or being removed.  A tracked receiver is kept alive for the duration of the
+	// call; if it has already expired the owner is told to remove the slot
+	template<class Func>
+	visit_result visit( Func&& func )
+	{
+		if ( blocked || delete_requested )
+			return visit_result::skipped;
+
+		if ( group ) {
+			if ( group->disconnected.load( std::memory_order_relaxed ) )
+				return visit_result::expired;
+
+			if ( group->blocked.load( std::memory_order_relaxed ) )
+				return visit_result::skipped;
+		}
+
+		if ( !tracked ) {
+			func( callback );
+			return visit_result::invoked;
+		}
+
+		auto guard = tracker.lock();
+		if ( !guard )
+			return visit_result::expired;
+
+		func( callback );
+		return visit_result::invoked;
+	}
+};
+
+class connection_target;
+
+// How a connection reaches back into the signal that made it
+struct connection_ops
+{
+	void (*disconnect)( connection_target *, std::size_t );
+	void (*block)( connection_target *, std::size_t );
+	void (*unblock)( connection_target *, std::size_t );
+};
+
+// Every signal that has handed out connections owns an entry here.  A
+// connection names its signal by entry index and generation; the
+// generation is bumped when the signal is destroyed, so a connection that
+// outlives its signal is recognized as stale instead of dereferencing it
+class signal_registry
+{
+	struct entry
+	{
+		std::atomic<connection_target *> target;
+		std::atomic<connection_ops const *> ops;
+		std::atomic<std::uint32_t> generation;
+		std::uint32_t next_free;
+	};
+
+	// Entries live in fixed chunks so they never move and connections
+	// resolve them without locking; only adding and removing signals
+	// takes the mutex.  The first chunk is part of the registry,
+	// which itself has static storage, so ordinary programs register their
+	// signals without allocating
+	static constexpr std::uint32_t chunk_size = 128;
+	static constexpr std::uint32_t max_chunks = 4096;
+	static constexpr std::uint32_t no_entry = std::uint32_t(-1);
+
+	using chunk = std::array<entry, chunk_size>;
+
+	std::mutex mutex;
+	chunk first;
+	std::atomic<chunk *> chunks[max_chunks];
+	std::atomic<std::uint32_t> entry_count{ 0 };
+	std::uint32_t free_entry = no_entry;
+
+	signal_registry()
+	{
+		chunks[0] = &first;
+		for ( std::uint32_t i = 1; i < max_chunks; ++i )
+			chunks[i] = nullptr;
+	}
+
+	entry& at( std::uint32_t index )
+	{
+		return ( *chunks[index / chunk_size].load( std::memory_order_acquire ) )
+			[index % chunk_size];
+	}
+
+public:
+	// Never destroyed, so signals with static storage may still release
+	// their entry at exit
+	static signal_registry& instance()
+	{
+		static typename std::aligned_storage< sizeof(signal_registry),
+		                                      alignof(signal_registry) >::type storage;
+		static signal_registry *registry = new (&storage) signal_registry;
+
+		return *registry;
+	}
+
+	std::uint32_t add( connection_target *target, connection_ops const& ops,
+	                   std::uint32_t& generation )
+	{
+		std::lock_guard<std::mutex> lock( mutex );
+
+		std::uint32_t index = free_entry;
+
+		if ( index == no_entry ) {
+			index = entry_count.load( std::memory_order_relaxed );
+
+			if ( index / chunk_size >= max_chunks )
+				throw std::length_error( "pac::signal_registry: too many signals" );
+
+			if ( index % chunk_size == 0 && index > 0 )
+				chunks[index / chunk_size].store( new chunk, std::memory_order_release );
+
+			at( index ).generation.store( 0, std::memory_order_relaxed );
+		} else {
+			free_entry = at( index ).next_free;
+		}
+
+		auto& e = at( index );
+		e.target.store( target, std::memory_order_relaxed );
+		e.ops.store( &ops, std::memory_order_relaxed );
+		generation = e.generation.load( std::memory_order_relaxed );
+
+		if ( index == entry_count.load( std::memory_order_relaxed ) )
+			entry_count.store( index + 1, std::memory_order_release );
+
+		return index;
+	}
+
+	void remove( std::uint32_t index )
+	{
+		std::lock_guard<std::mutex> lock( mutex );
+
+		auto& e = at( index );
+		e.generation.fetch_add( 1, std::memory_order_release );
+		e.target.store( nullptr, std::memory_order_relaxed );
+		e.next_free = free_entry;
+		free_entry = index;
+	}
+
+	// Like the signal itself, a connection must not be used while another
+	// thread destroys its signal; a signal destroyed earlier is detected
+	bool resolve( std::uint32_t index, std::uint32_t generation,
+	              connection_target *& target, connection_ops const *& ops )
+	{
+		if ( index >= entry_count.load( std::memory_order_acquire ) )
+			return false;
+
+		auto& e = at( index );
+		if ( e.generation.load( std::memory_order_acquire ) != generation )
+			return false;
+
+		target = e.target.load( std::memory_order_acquire );
+		ops = e.ops.load( std::memory_order_relaxed );
+
+		return target != nullptr;
+	}
+};
+
+// Handle to a connected slot: the signal's registry entry and the slot id,
+// which the signal resolves through its own handle table.  Owning a
+// connection keeps the slot connected; it disconnects when destroyed unless
+// detached first.  Connections move but do not copy
+class connection
+{
+	friend class connection_target;
+
+	static constexpr std::uint32_t no_signal = std::uint32_t(-1);
+
+	std::uint32_t signal_index = no_signal;
+	std::uint32_t signal_generation = 0;
+	std::size_t slot_id = 0;
+
+	connection( std::uint32_t index, std::uint32_t generation, std::size_t id )
+		: signal_index( index ),
+		  signal_generation( generation ),
+		  slot_id( id )
+	{}
+
+	template<class Func>
+	void call( Func func ) const
+	{
+		if ( signal_index == no_signal )
+			return;
+
+		connection_target *target;
+		connection_ops const *ops;
+
+		if ( signal_registry::instance().resolve( signal_index, signal_generation,
+		                                          target, ops ) )
+			func( *ops, target );
+	}
+
+public:
+	connection() = default;
+
+	connection( connection&& other ) noexcept
+		: signal_index( other.signal_index ),
+		  signal_generation( other.signal_generation ),
+		  slot_id( other.slot_id )
+	{
+		other.signal_index = no_signal;
+	}
+
+	connection& operator=( connection&& other ) noexcept
+	{
+		if ( this != &other ) {
+			disconnect();
+
+			signal_index = other.signal_index;
+			signal_generation = other.signal_generation;
+			slot_id = other.slot_id;
+
+			other.signal_index = no_signal;
+		}
+
+		return *this;
+	}
+
+	connection( connection const& ) = delete;
+	connection& operator=( connection const& ) = delete;
+
+	~connection()
+	{
+		disconnect();
+	}
+
+	bool operator==(const connection& other) const
+	{
+		return ( signal_index == other.signal_index &&
+		         signal_generation == other.signal_generation &&
+		         slot_id == other.slot_id );
+	}
+
+	std::size_t id() const
+	{
+		return slot_id;
+	}
+
+	void disconnect()
+	{
+		auto id = slot_id;
+		call( [id]( connection_ops const& ops, connection_target *target )
+		      { ops.disconnect( target, id ); } );
+
+		signal_index = no_signal;
+	}
+
+	void block()
+	{
+		auto id = slot_id;
+		call( [id]( connection_ops const& ops, connection_target *target )
+		      { ops.block( target, id ); } );
+	}
+
+	void unblock()
+	{
+		auto id = slot_id;
+		call( [id]( connection_ops const& ops, connection_target *target )
+		      { ops.unblock( target, id ); } );
+	}
+
+	// Leave the slot connected for the signal's lifetime
+	void detach()
+	{
+		signal_index = no_signal;
+	}
+};
+
+// Base of the signals handing out connections.  The registry entry is taken
+// on the first connect and released, along with every outstanding
+// connection, when the signal is destroyed.  The entry points at the
+// signal, so signals deriving from this never move
+class connection_target
+{
+	static constexpr std::uint32_t unregistered = std::uint32_t(-1);
+
+	std::uint32_t registry_index = unregistered;
+	std::uint32_t registry_generation = 0;
+
+protected:
+	connection_target() = default;
+
+	connection_target( connection_target const& ) = delete;
+	connection_target& operator=( connection_target const& ) = delete;
+
+	~connection_target()
+	{
+		release_connections();
+	}
+
+	connection make_connection( connection_ops const& ops, std::size_t id )
+	{
+		if ( registry_index == unregistered )
+			registry_index = signal_registry::instance().add( this, ops,
+			                                                  registry_generation );
+
+		return connection( registry_index, registry_generation, id );
+	}
+
+	// Outstanding connections go stale; signals call this first thing in
+	// their destructor so that slots destroyed afterwards cannot reach them
+	void release_connections()
+	{
+		if ( registry_index == unregistered )
+			return;
+
+		signal_registry::instance().remove( registry_index );
+		registry_index = unregistered;
+	}
+};
+
+// Slots connected on behalf of one owner, e.g. a presentation panel, over
+// any number of signals.  Disconnecting or blocking the group is a single
+// flag shared with its slots: each signal skips them from then on and
+// purges the disconnected ones the next time it emits, so tearing down an
+// owner costs nothing per slot.  A group disconnects when destroyed
+class connection_group
+{
+	memory_resource *resource;
+	std::shared_ptr<group_state> state;
+
+public:
+	connection_group()
+		: connection_group( get_default_resource() )
+	{}
+
+	explicit connection_group( memory_resource *res )
+		: resource( res )
+	{}
+
+	connection_group( connection_group&& ) = default;
+
+	connection_group& operator=( connection_group&& other )
+	{
+		if ( this != &other ) {
+			disconnect();
+			resource = other.resource;
+			state = std::move( other.state );
+		}
+
+		return *this;
+	}
+
+	~connection_group()
+	{
+		disconnect();
+	}
+
+	// Slots connected afterwards start a fresh, unblocked group
+	void disconnect()
+	{
+		if ( !state )
+			return;
+
+		state->disconnected.store( true, std::memory_order_relaxed );
+		state.reset();
+	}
+
+	void block()
+	{
+		share()->blocked.store( true, std::memory_order_relaxed );
+	}
+
+	void unblock()
+	{
+		share()->blocked.store( false, std::memory_order_relaxed );
+	}
+
+	bool blocked() const
+	{
+		return state && state->blocked.load( std::memory_order_relaxed );
+	}
+
+	// State handed to the slots connected in the group
+	std::shared_ptr<group_state> const& share()
+	{
+		if ( !state )
+			state = std::allocate_shared<group_state>(
+				polymorphic_allocator<group_state>( resource ) );
+
+		return state;
+	}
+};
+
+}
+
+namespace std {
+template<>
+struct hash<pac::connection>
+{
+	std::size_t operator()(pac::connection const& con) const
+	{
+		return std::hash<std::size_t>()( con.id() );
+	}
+};
+
+}
+
+namespace pac {
+
+// Slots found expired while dispatching are reported by id to the owner
+struct invoker_base
+{
+	using expire_type = callback_ref<void(std::size_t)>;
+
+	expire_type expire;
+
+	// Set by a slot calling stop_emission; the remaining slots are skipped
+	bool stopped = false;
+
+	explicit invoker_base( expire_type e )
+		: expire( e )
+	{}
+
+	template<class Slot, class Func>
+	void visit( Slot& slot, Func&& func )
+	{
+		if ( slot.visit( std::forward<Func>(func) ) == visit_result::expired )
+			expire( slot.id );
+	}
+};
+
+template<class Signature>
+struct invoker;
+
+template<class Ret, class... Args>
+struct invoker<Ret(Args...)> : invoker_base
+{
+	using invoker_base::invoker_base;
+
+	using return_type = Ret;
+	using results_type = std::vector<return_type>;
+	using sink_type = callback_ref<void(return_type)>;
+
+	// Arguments are handed to every slot as lvalues; forwarding an rvalue
+	// would let the first slot move from it before the others run
+	template<class SlotIt, class... A>
+	results_type dispatch(SlotIt beg, SlotIt end, A&&... args)
+	{
+		results_type results;
+
+		dispatch_with( [&results]( return_type ret )
+		               {
+			               results.push_back( std::move( ret ) );
+		               },
+		               beg, end, std::forward<A>(args)... );
+
+		return results;
+	}
+
+	template<class SlotIt, class... A>
+	void dispatch_with(sink_type sink, SlotIt beg, SlotIt end, A&&... args)
+	{
+		auto it = beg;
+
+		for ( ; !stopped && it != end; ++it ) {
+			visit( *it,
+				[&]( auto& cb )
+				{
+					sink( cb( args... ) );
+				} );
+		}
+	}
+
+	// Stops visiting slots as soon as combiner has its answer
+	template<class Combiner, class SlotIt, class... A>
+	void dispatch_combine(Combiner& combiner, SlotIt beg, SlotIt end, A&&... args)
+	{
+		bool more = true;
+
+		for ( auto it = beg; more && !stopped && it != end; ++it ) {
+			visit( *it,
+				[&]( auto& cb )
+				{
+					more = combiner( cb( args... ) );
+				} );
+		}
+	}
+};
+
+template<class... Args>
+struct invoker<void(Args...)> : invoker_base
+{
+	using invoker_base::invoker_base;
+
+	using return_type = void;
+	using results_type = void;
+	using sink_type = callback_ref<void()>;
+
+	using callback_type = callback<void( Args... )>;
+	using slot_type = slot<callback_type>;
+
+	template<class SlotIt, class... A>
+	return_type dispatch(SlotIt beg, SlotIt end, A&&... args)
+	{
+		auto it = beg;
+
+		for ( ; !stopped && it != end; ++it ) {
+			visit( *it,
+				[&]( auto& cb )
+				{
+					cb( args... );
+				} );
+		}
+
+	}
+
+	template<class SlotIt, class... A>
+	void dispatch_with(sink_type sink, SlotIt beg, SlotIt end, A&&... args)
+	{
+		auto it = beg;
+
+		for ( ; !stopped && it != end; ++it ) {
+			visit( *it,
+				[&]( auto& cb )
+				{
+					cb( args... );
+					sink();
+				} );
+		}
+	}
+
+};
+
+// Signals taking a single argument and returning nothing can have batch
+// receivers, called with a span of argument values
+struct no_batch_value
+{};
+
+template<class Signature>
+struct batch_traits
+{
+	static constexpr bool enabled = false;
+	using value_type = no_batch_value;
+};
+
+template<class Arg>
+struct batch_traits<void(Arg)>
+{
+	static constexpr bool enabled = true;
+	using value_type = typename std::decay<Arg>::type;
+};
+
+template<class T>
+struct is_tuple
+	: std::false_type
+{};
+
+template<class... T>
+struct is_tuple< std::tuple<T...> >
+	: std::true_type
+{};
+
+// Results of a parallel emission, gathered per run of slots and joined in
+// run order
+template<class Ret>
+struct parallel_results
+{
+	std::vector< std::vector<Ret> > runs;
+
+	explicit parallel_results( std::size_t n )
+		: runs( n )
+	{}
+
+	template<class Invoker, class SlotIt, class... A>
+	void dispatch( std::size_t run, Invoker& inv, SlotIt beg, SlotIt end, A&... args )
+	{
+		runs[run] = inv.dispatch( beg, end, args... );
+	}
+
+	std::vector<Ret> join()
+	{
+		std::vector<Ret> results;
+
+		for ( auto& run : runs )
+			for ( auto& r : run )
+				results.push_back( std::move( r ) );
+
+		return results;
+	}
+};
+
+template<>
+struct parallel_results<void>
+{
+	explicit parallel_results( std::size_t )
+	{}
+
+	template<class Invoker, class SlotIt, class... A>
+	void dispatch( std::size_t, Invoker& inv, SlotIt beg, SlotIt end, A&... args )
+	{
+		inv.dispatch( beg, end, args... );
+	}
+
+	void join()
+	{}
+};
+
+template<class Signature>
+class signal_body;
+
+// Slots and bookkeeping of an st_policy signal; see signal below
+template<class Ret, class... Args>
+class signal_body<Ret(Args...)> : connection_target
+{
+public:
+	using results_type = typename invoker<Ret(Args...)>::results_type;
+	using sink_type = typename invoker<Ret(Args...)>::sink_type;
+	using callback_type = callback<Ret( Args... )>;
+	using slot_type = slot<callback_type>;
+
+	using batch_value_type = typename batch_traits<Ret(Args...)>::value_type;
+	using batch_callback_type = callback< void( span<batch_value_type const> ) >;
+
+	friend struct invoker<Ret(Args...)>;
+
+private:
+	using slot_vector = std::vector< slot_type, polymorphic_allocator<slot_type> >;
+
+	// A connection id is a handle index in its low half and the handle's
+	// generation in its high half; the handle maps it to the slot position
+	// so ids stay stable while slots are compacted, and a stale id never
+	// matches a reused handle
+	struct slot_handle
+	{
+		std::uint32_t generation;
+		std::uint32_t position;
+	};
+
+	using handle_vector = std::vector< slot_handle, polymorphic_allocator<slot_handle> >;
+	using index_vector = std::vector< std::uint32_t, polymorphic_allocator<std::uint32_t> >;
+
+	static constexpr std::size_t id_bits = sizeof(std::size_t) * 4;
+	static constexpr std::size_t index_mask = ( std::size_t(1) << id_bits ) - 1;
+
+	memory_resource *resource;
+
+	// Room for the first slot, its handle and its active entry, so a
+	// signal with one connection allocates nothing beyond its body
+	inline_buffer_resource< sizeof(slot_type) + sizeof(slot_handle) +
+	                        sizeof(std::uint32_t) + 2 * alignof(std::max_align_t) > local;
+
+	// Slots by descending priority, then in connection order, iterated
+	// linearly by emit
+	slot_vector slots;
+
+	// Slots connected during an emission; inserted once the outermost
+	// emission returns so slots never reallocates under an iteration
+	slot_vector pending;
+
+	handle_vector handles;
+	index_vector free_handles;
+
+	// Handles of slots disconnected during an emission, released once the
+	// outermost emission returns.  Released slots stay behind as tombstones
+	// until they make up half of slots
+	index_vector doomed;
+	std::size_t tombstones = 0;
+
+	// Positions of the slots an emission visits, in slot order: none that
+	// are tombstoned, and none blocked as of the last rebuild.  Blocking
+	// leaves it alone, since emission checks the flag anyway; unblocking
+	// inserts the slot back.  Connecting and purging mark it stale and the
+	// next outermost emission rebuilds it
+	index_vector active;
+	bool active_stale = false;
+
+	// Batch receivers, indexed by slot::batch_index.  Each is allocated on
+	// its own and shared with its slot's callback, so connecting another
+	// receiver never moves one.  Created by the first connect_batch
+	using batch_ptr = std::shared_ptr<batch_callback_type>;
+	using batch_deque = std::deque< batch_ptr, polymorphic_allocator<batch_ptr> >;
+
+	resource_unique_ptr<batch_deque> batches;
+	index_vector free_batches;
+
+	std::size_t dispatch_depth = 0;
+
+	// Invoker of the innermost emission, for stop_emission
+	invoker_base *current_frame = nullptr;
+
+public:
+	// Slots and callbacks too large to be stored inline are allocated
+	// from res
+	explicit signal_body( memory_resource *res )
+		: resource( res ),
+		  local( res ),
+		  slots( polymorphic_allocator<slot_type>( &local ) ),
+		  pending( polymorphic_allocator<slot_type>( &local ) ),
+		  handles( polymorphic_allocator<slot_handle>( &local ) ),
+		  free_handles( polymorphic_allocator<std::uint32_t>( &local ) ),
+		  doomed( polymorphic_allocator<std::uint32_t>( &local ) ),
+		  active( polymorphic_allocator<std::uint32_t>( &local ) ),
+		  free_batches( polymorphic_allocator<std::uint32_t>( &local ) )
+	{}
+
+	~signal_body()
+	{
+		release_connections();
+	}
+
+	signal_body(signal_body const&) = delete;
+	signal_body& operator=(signal_body const&) = delete;
+
+	memory_resource *get_memory_resource() const
+	{
+		return resource;
+	}
+
+	std::size_t slot_count() const
+	{
+		return slots.size() - tombstones + pending.size();
+	}
+
+	connection connect_slot( slot_type slot )
+	{
+		std::uint32_t index;
+
+		if ( free_handles.empty() ) {
+			index = static_cast<std::uint32_t>( handles.size() );
+			handles.push_back( slot_handle{ 0, 0 } );
+		} else {
+			index = free_handles.back();
+			free_handles.pop_back();
+		}
+
+		auto& handle = handles[index];
+		slot.id = ( std::size_t( handle.generation ) << id_bits ) | index;
+
+		auto con = make_connection( ops(), slot.id );
+
+		if ( dispatch_depth > 0 ) {
+			handle.position = static_cast<std::uint32_t>( slots.size() + pending.size() );
+			pending.push_back( std::move( slot ) );
+		} else {
+			insert_slot( std::move( slot ) );
+			active_stale = true;
+		}
+
+		return con;
+	}
+
+	// Connect anything make_slot accepts: a callback, a callable, or a
+	// member function with its receiver
+	template<class... T>
+	connection connect( T&&... t )
+	{
+		return connect_slot( make_slot( std::forward<T>(t)... ) );
+	}
+
+	// Connect with a priority: slots run from the highest priority down,
+	// those of equal priority in connection order.  Plain connects have
+	// priority 0.  Slots are kept in that order as they connect, so
+	// emitting never sorts
+	template<class... T>
+	connection connect( int priority, T&&... t )
+	{
+		auto slot = make_slot( std::forward<T>(t)... );
+		slot.priority = priority;
+
+		return connect_slot( std::move( slot ) );
+	}
+
+	// Connect on behalf of group, which owns the slot from then on; the
+	// returned connection is empty
+	template<class... T>
+	connection connect( connection_group& group, T&&... t )
+	{
+		auto slot = make_slot( std::forward<T>(t)... );
+		slot.group = group.share();
+		connect_slot( std::move( slot ) ).detach();
+
+		return connection();
+	}
+
+	template<class... T>
+	connection connect( connection_group& group, int priority, T&&... t )
+	{
+		auto slot = make_slot( std::forward<T>(t)... );
+		slot.group = group.share();
+		slot.priority = priority;
+		connect_slot( std::move( slot ) ).detach();
+
+		return connection();
+	}
+
+	template<class Signature>
+	slot_type make_slot( pac::callback<Signature> cb )
+	{
+		return slot_type( callback_type( cb ) );
+	}
+
+	template<class Func>
+	slot_type make_slot( Func func )
+	{
+		callback_type cb{ std::allocator_arg, resource, std::move( func ) };
+		return slot_type( std::move( cb ) );
+	}
+
+	// A member function of a receiver owned by a shared_ptr; the slot is
+	// skipped and purged once the receiver is destroyed, so no connection
+	// needs to be kept around just for teardown
+	template<class T, class PMemFunc>
+	slot_type make_slot( PMemFunc mfunc, std::weak_ptr<T> obj )
+	{
+		callback_type cb{ std::allocator_arg, resource, mfunc, obj.lock().get() };
+		return slot_type( std::move( cb ), std::move( obj ) );
+	}
+
+	template<class T, class PMemFunc>
+	slot_type make_slot( PMemFunc mfunc, T&& obj )
+	{
+		callback_type cb{ std::allocator_arg, resource, mfunc, std::forward<T>(obj) };
+		return slot_type( std::move( cb ) );
+	}
+
+	// Connect a receiver taking span<T const>, for void(T) signals.
+	// emit_batch hands it runs of values at once; emit hands it a span of
+	// one value
+	template<class Func, class Signature = Ret(Args...),
+	         class = typename std::enable_if<
+		         batch_traits<Signature>::enabled >::type>
+	connection connect_batch( Func func )
+	{
+		auto batch_cb = std::allocate_shared<batch_callback_type>(
+			polymorphic_allocator<batch_callback_type>( resource ),
+			std::allocator_arg, resource, std::move( func ) );
+		std::uint32_t index;
+
+		if ( !batches )
+			batches = allocate_unique<batch_deque>(
+				resource, polymorphic_allocator<batch_ptr>( resource ) );
+
+		if ( free_batches.empty() ) {
+			index = static_cast<std::uint32_t>( batches->size() );
+			batches->push_back( batch_cb );
+		} else {
+			index = free_batches.back();
+			free_batches.pop_back();
+			( *batches )[index] = batch_cb;
+		}
+
+		slot_type slot(
+			callback_type{
+				[batch_cb]( batch_value_type const& value )
+				{
+					( *batch_cb )( span<batch_value_type const>( &value, 1 ) );
+				} } );
+		slot.batch_index = index;
+
+		return connect_slot( std::move( slot ) );
+	}
+
+	void disconnect( connection& con )
+	{
+		con.disconnect();
+	}
+
+	void disconnect( std::size_t con_id )
+	{
+		request_delete( con_id );
+
+		if ( dispatch_depth == 0 )
+			purge();
+	}
+
+	void block( std::size_t con_id )
+	{
+		set_blocked( con_id, true );
+	}
+
+	void unblock( std::size_t con_id )
+	{
+		set_blocked( con_id, false );
+	}
+
+	// Called from a slot, skip the slots after it in the emission running
+	// it, e.g. once an input event is handled; outer emissions carry on
+	void stop_emission()
+	{
+		if ( current_frame )
+			current_frame->stopped = true;
+	}
+
+	template<class... A>
+	results_type emit(A&&... args)
+	{
+		auto expire = [this]( std::size_t id ) { request_delete( id ); };
+		invoker<Ret(Args...)> inv( expire );
+
+		scoped_dec<std::size_t> dec( ++dispatch_depth );
+		scoped_cleanup<decltype(*this)> cleanup_deleted_slots( *this );
+		scoped_frame frame( current_frame, &inv );
+
+		auto it = active_begin();
+		auto end = active_end();
+
+		return inv.dispatch( it, end, std::forward<A>(args)... );
+	}
+
+	// Emit handing each slot result to sink instead of collecting them;
+	// for void signals sink is called once after each slot
+	template<class... A>
+	void emit_with(sink_type sink, A&&... args)
+	{
+		auto expire = [this]( std::size_t id ) { request_delete( id ); };
+		invoker<Ret(Args...)> inv( expire );
+
+		scoped_dec<std::size_t> dec( ++dispatch_depth );
+		scoped_cleanup<decltype(*this)> cleanup_deleted_slots( *this );
+		scoped_frame frame( current_frame, &inv );
+
+		auto it = active_begin();
+		auto end = active_end();
+
+		inv.dispatch_with( sink, it, end, std::forward<A>(args)... );
+	}
+
+	// Emit reducing the slot results with a combiner, e.g.
+	// emit_with<pac::last_value>( args... ) or emit_with<pac::any_of>( args... )
+	template<template<class> class Combiner, class... A>
+	typename Combiner<Ret>::result_type emit_with(A&&... args)
+	{
+		Combiner<Ret> combiner;
+		return emit_with( combiner, std::forward<A>(args)... );
+	}
+
+	// Emit reducing the slot results with a combiner object, such as
+	// pac::fold( init, reducer ); the combiner keeps its state afterwards
+	template<class Combiner, class... A>
+	auto emit_with(Combiner& combiner, A&&... args)
+		-> typename std::enable_if< is_combiner<Combiner>::value,
+		                            decltype( combiner.result() ) >::type
+	{
+		{
+			auto expire = [this]( std::size_t id ) { request_delete( id ); };
+			invoker<Ret(Args...)> inv( expire );
+
+			scoped_dec<std::size_t> dec( ++dispatch_depth );
+			scoped_cleanup<decltype(*this)> cleanup_deleted_slots( *this );
+			scoped_frame frame( current_frame, &inv );
+
+			auto it = active_begin();
+			auto end = active_end();
+
+			inv.dispatch_combine( combiner, it, end, std::forward<A>(args)... );
+		}
+
+		return combiner.result();
+	}
+
+	template<class Combiner, class... A>
+	auto emit_with(Combiner&& combiner, A&&... args)
+		-> typename std::enable_if< is_combiner<Combiner>::value &&
+		                            !std::is_reference<Combiner>::value,
+		                            decltype( combiner.result() ) >::type
+	{
+		return emit_with( combiner, std::forward<A>(args)... );
+	}
+
+	// Deliver every argument set in items slot by slot: each slot handles
+	// the whole batch before the next one runs.  Elements are tuples of
+	// the arguments, or plain values for single argument signals.  Batch
+	// receivers are called once if items is contiguous (has data()).
+	// Results of non-void slots are discarded
+	template<class Range>
+	void emit_batch( Range const& items )
+	{
+		auto expire = [this]( std::size_t id ) { request_delete( id ); };
+		invoker<Ret(Args...)> inv( expire );
+
+		scoped_dec<std::size_t> dec( ++dispatch_depth );
+		scoped_cleanup<decltype(*this)> cleanup_deleted_slots( *this );
+		scoped_frame frame( current_frame, &inv );
+
+		auto it = active_begin();
+		auto end = active_end();
+
+		for ( ; !inv.stopped && it != end; ++it ) {
+			auto& slot = *it;
+
+			inv.visit( slot,
+				[&]( auto& cb )
+				{
+					this->deliver_batch(
+						slot, cb, items,
+						std::integral_constant<
+							bool, batch_traits<Ret(Args...)>::enabled >() );
+				} );
+		}
+	}
+
+	// Emit with the active slots split into contiguous runs, one on the
+	// calling thread and one on each toe of pool (see toe_pool), and wait
+	// for all of them; results come back in slot order.  The slots run
+	// concurrently, so they must be independent of each other, must not
+	// connect to or disconnect from this signal and cannot stop the
+	// emission.  An exception thrown by a slot on a toe is rethrown here
+	// once every run has finished.  Don't call it from one of pool's toes
+	template<class Pool, class... A>
+	results_type emit_parallel(Pool& pool, A&&... args)
+	{
+		std::mutex expire_mutex;
+		auto expire = [this, &expire_mutex]( std::size_t id )
+		{
+			std::lock_guard<std::mutex> lock( expire_mutex );
+			request_delete( id );
+		};
+
+		scoped_dec<std::size_t> dec( ++dispatch_depth );
+		scoped_cleanup<decltype(*this)> cleanup_deleted_slots( *this );
+		scoped_frame frame( current_frame, nullptr );
+
+		auto beg = active_begin();
+		auto end = active_end();
+
+		std::size_t count = end.position - beg.position;
+		std::size_t runs = std::min( pool.size() + 1, count );
+		if ( runs == 0 )
+			runs = 1;
+
+		parallel_results<Ret> results( runs );
+		latch done( runs - 1 );
+
+		std::mutex failure_mutex;
+		std::exception_ptr failure;
+
+		auto run_bounds = [&]( std::size_t run )
+		{
+			auto first = beg;
+			auto last = beg;
+			first.position += count * run / runs;
+			last.position += count * ( run + 1 ) / runs;
+			return std::make_pair( first, last );
+		};
+
+		for ( std::size_t run = 1; run < runs; ++run ) {
+			pool.post( run - 1, callback<void()>(
+				           [&, run]()
+				           {
+					           struct count_down_on_exit
+					           {
+						           latch& l;
+
+						           ~count_down_on_exit()
+						           {
+							           l.count_down();
+						           }
+					           } finished{ done };
+
+					           try {
+						           invoker<Ret(Args...)> inv( expire );
+						           auto bounds = run_bounds( run );
+
+						           results.dispatch( run, inv, bounds.first,
+						                             bounds.second, args... );
+					           }
+					           catch (...) {
+						           std::lock_guard<std::mutex> lock( failure_mutex );
+						           if ( !failure )
+							           failure = std::current_exception();
+					           }
+				           } ) );
+		}
+
+		{
+			// the other runs refer to this frame, so wait for them even
+			// if a slot throws here
+			struct wait_for_runs
+			{
+				latch& l;
+
+				~wait_for_runs()
+				{
+					l.wait();
+				}
+			} wait{ done };
+
+			invoker<Ret(Args...)> inv( expire );
+			auto bounds = run_bounds( 0 );
+
+			results.dispatch( 0, inv, bounds.first, bounds.second, args... );
+		}
+
+		if ( failure )
+			std::rethrow_exception( failure );
+
+		return results.join();
+	}
+
+private:
+	template<class Range, class = void>
+	struct is_contiguous
+		: std::false_type
+	{};
+
+	template<class Range>
+	struct is_contiguous<
+		Range, typename std::enable_if<
+			std::is_convertible<
+				decltype( std::declval<Range const&>().data() ),
+				batch_value_type const * >::value >::type >
+		: std::true_type
+	{};
+
+	template<class Item>
+	static void invoke_item( callback_type& cb, Item const& item, std::true_type )
+	{
+		pac::apply( cb, item );
+	}
+
+	template<class Item>
+	static void invoke_item( callback_type& cb, Item const& item, std::false_type )
+	{
+		cb( item );
+	}
+
+	template<class Range>
+	void deliver_batch( slot_type&, callback_type& cb, Range const& items,
+	                    std::false_type )
+	{
+		for ( auto const& item : items )
+			invoke_item( cb, item, is_tuple<
+				typename std::decay<decltype( item )>::type >() );
+	}
+
+	template<class Range>
+	void deliver_batch( slot_type& slot, callback_type& cb, Range const& items,
+	                    std::true_type )
+	{
+		if ( slot.batch_index == std::uint32_t(-1) ) {
+			deliver_batch( slot, cb, items, std::false_type() );
+			return;
+		}
+
+		deliver_batch_to( *( *batches )[slot.batch_index], items,
+		                  is_contiguous<Range>() );
+	}
+
+	template<class Range>
+	static void deliver_batch_to( batch_callback_type& batch_cb,
+	                              Range const& items, std::true_type )
+	{
+		batch_cb( span<batch_value_type const>( items.data(), items.size() ) );
+	}
+
+	template<class Range>
+	static void deliver_batch_to( batch_callback_type& batch_cb,
+	                              Range const& items, std::false_type )
+	{
+		for ( auto const& item : items )
+			batch_cb( span<batch_value_type const>( &batch_value( item ), 1 ) );
+	}
+
+	template<class T>
+	static batch_value_type const& batch_value( std::tuple<T> const& item )
+	{
+		return std::get<0>( item );
+	}
+
+	static batch_value_type const& batch_value( batch_value_type const& item )
+	{
+		return item;
+	}
+
+	// Walks active; slots and active are only reallocated outside of
+	// emissions, so the range stays valid while slots connect and disconnect
+	struct active_iterator
+	{
+		slot_type *base;
+		std::uint32_t const *position;
+
+		slot_type& operator*() const
+		{
+			return base[*position];
+		}
+
+		active_iterator& operator++()
+		{
+			++position;
+			return *this;
+		}
+
+		bool operator!=( active_iterator const& other ) const
+		{
+			return position != other.position;
+		}
+	};
+
+	active_iterator active_begin()
+	{
+		// nested emissions keep the outer emission's view; blocked flags
+		// are still honoured when visiting
+		if ( active_stale && dispatch_depth == 1 ) {
+			active.clear();
+
+			for ( std::size_t i = 0; i < slots.size(); ++i )
+				if ( !slots[i].blocked && !slots[i].delete_requested )
+					active.push_back( static_cast<std::uint32_t>( i ) );
+
+			active_stale = false;
+		}
+
+		return active_iterator{ slots.data(), active.data() };
+	}
+
+	active_iterator active_end()
+	{
+		return active_iterator{ slots.data(), active.data() + active.size() };
+	}
+
+	void set_blocked( std::size_t con_id, bool blocked )
+	{
+		auto slot = find_slot( con_id );
+		if ( !slot || slot->blocked == blocked )
+			return;
+
+		slot->blocked = blocked;
+
+		if ( !blocked && !active_stale && !slot->delete_requested )
+			reactivate( handles[con_id & index_mask].position );
+	}
+
+	// Put an unblocked slot back into active, unless it never left or an
+	// emission is walking active right now; pending slots join on purge
+	void reactivate( std::uint32_t position )
+	{
+		if ( position >= slots.size() )
+			return;
+
+		if ( dispatch_depth > 0 ) {
+			active_stale = true;
+			return;
+		}
+
+		auto it = std::lower_bound( active.begin(), active.end(), position );
+
+		if ( it == active.end() || *it != position )
+			active.insert( it, position );
+	}
+
+	slot_type *find_slot( std::size_t con_id )
+	{
+		auto index = con_id & index_mask;
+
+		if ( index >= handles.size() ||
+		     handles[index].generation != ( con_id >> id_bits ) )
+			return nullptr;
+
+		auto position = handles[index].position;
+		if ( position < slots.size() )
+			return &slots[position];
+
+		return &pending[position - slots.size()];
+	}
+
+	void request_delete( std::size_t con_id )
+	{
+		auto slot = find_slot( con_id );
+		if ( !slot || slot->delete_requested )
+			return;
+
+		slot->delete_requested = true;
+		doomed.push_back( static_cast<std::uint32_t>( con_id & index_mask ) );
+	}
+
+	// Release the slots disconnected since the last purge and append the
+	// ones connected meanwhile; free when neither happened
+	void purge()
+	{
+		if ( doomed.empty() && pending.empty() )
+			return;
+
+		// Destroying a callback may disconnect or connect other slots; treat
+		// that as happening during an emission so it lands on the lists
+		// being processed here
+		scoped_dec<std::size_t> dec( ++dispatch_depth );
+
+		for ( std::size_t i = 0; i < doomed.size(); ++i ) {
+			auto index = doomed[i];
+			auto position = handles[index].position;
+
+			++handles[index].generation;
+			free_handles.push_back( index );
+
+			// pending slots are dropped below instead
+			auto& slot = position < slots.size()
+				? slots[position] : pending[position - slots.size()];
+
+			auto batch_index = slot.batch_index;
+			if ( batch_index != std::uint32_t(-1) ) {
+				free_batches.push_back( batch_index );
+				( *batches )[batch_index].reset();
+			}
+
+			if ( position < slots.size() ) {
+				slot.callback = callback_type();
+				slot.tracker.reset();
+				++tombstones;
+			}
+		}
+
+		doomed.clear();
+
+		for ( auto& slot : pending ) {
+			if ( slot.delete_requested )
+				continue;
+
+			insert_slot( std::move( slot ) );
+		}
+
+		pending.clear();
+		active_stale = true;
+
+		if ( tombstones * 2 > slots.size() )
+			compact();
+	}
+
+	// Place slot after every slot of its priority or higher; only slots of
+	// a higher priority than the last one shift the others
+	void insert_slot( slot_type slot )
+	{
+		std::size_t position = slots.size();
+
+		if ( !slots.empty() && slots.back().priority < slot.priority ) {
+			auto it = std::upper_bound(
+				slots.begin(), slots.end(), slot.priority,
+				[]( int priority, slot_type const& other )
+				{
+					return priority > other.priority;
+				} );
+
+			position = it - slots.begin();
+			slots.insert( it, std::move( slot ) );
+		} else {
+			slots.push_back( std::move( slot ) );
+		}
+
+		// tombstones no longer own their handle, which may have been reused
+		for ( auto i = position; i < slots.size(); ++i )
+			if ( !slots[i].delete_requested )
+				handles[slots[i].id & index_mask].position =
+					static_cast<std::uint32_t>( i );
+	}
+
+	// Squeeze out the tombstones, keeping slot order
+	void compact()
+	{
+		auto out = slots.begin();
+
+		for ( auto it = slots.begin(); it != slots.end(); ++it ) {
+			if ( it->delete_requested )
+				continue;
+
+			if ( out != it ) {
+				*out = std::move( *it );
+				handles[out->id & index_mask].position =
+					static_cast<std::uint32_t>( out - slots.begin() );
+			}
+			++out;
+		}
+
+		slots.erase( out, slots.end() );
+		tombstones = 0;
+
+		active.clear();
+		active_stale = true;
+	}
+
+	static connection_ops const& ops()
+	{
+		static const connection_ops table{
+			[]( connection_target *sig, std::size_t id )
+			{ static_cast<signal_body *>( sig )->disconnect( id ); },
+			[]( connection_target *sig, std::size_t id )
+			{ static_cast<signal_body *>( sig )->block( id ); },
+			[]( connection_target *sig, std::size_t id )
+			{ static_cast<signal_body *>( sig )->unblock( id ); } };
+
+		return table;
+	}
+
+	struct scoped_frame
+	{
+		invoker_base *& current;
+		invoker_base *previous;
+
+		scoped_frame( invoker_base *& cur, invoker_base *inv )
+			: current( cur ), previous( cur )
+		{
+			current = inv;
+		}
+
+		~scoped_frame()
+		{
+			current = previous;
+		}
+	};
+
+	template<class T>
+	struct scoped_dec
+	{
+		T& obj;
+
+		scoped_dec(T& obj_)
+			: obj(obj_)
+		{}
+
+		~scoped_dec()
+		{
+			--obj;
+		}
+	};
+
+	template<class Signal>
+	struct scoped_cleanup
+	{
+		Signal& sig;
+		scoped_cleanup(Signal& sig_)
+			: sig(sig_)
+		{}
+
+		~scoped_cleanup()
+		{
+			// Nested emissions are still iterating the slots
+			if ( sig.dispatch_depth > 1 )
+				return;
+
+			sig.purge();
+		}
+	};
+
+	friend struct scoped_cleanup< signal_body<Ret(Args...)> >;
+};
+
+
+// Signals are mostly left unconnected or carry a single slot, so a signal
+// is a single word: the memory resource until the first connect, and the
+// body holding the slots, allocated from that resource, from then on.  The
+// body has room for one slot inline, so a signal with one connection costs
+// a single allocation; it never moves, so connections refer to it directly
+template<class Ret, class... Args>
+class signal<Ret(Args...), st_policy>
+{
+public:
+	using body_type = signal_body<Ret(Args...)>;
+
+	using results_type = typename body_type::results_type;
+	using sink_type = typename body_type::sink_type;
+	using callback_type = typename body_type::callback_type;
+	using slot_type = typename body_type::slot_type;
+
+	using batch_value_type = typename body_type::batch_value_type;
+	using batch_callback_type = typename body_type::batch_callback_type;
+
+private:
+	// body_type * once connected, otherwise memory_resource * tagged in
+	// the low bit
+	std::uintptr_t state;
+
+	static std::uintptr_t unconnected( memory_resource *res )
+	{
+		return reinterpret_cast<std::uintptr_t>( res ) | 1;
+	}
+
+	body_type *body() const
+	{
+		return ( state & 1 ) ? nullptr : reinterpret_cast<body_type *>( state );
+	}
+
+	body_type& connected_body()
+	{
+		if ( state & 1 ) {
+			auto res = reinterpret_cast<memory_resource *>( state & ~std::uintptr_t(1) );
+			state = reinterpret_cast<std::uintptr_t>(
+				allocate_unique<body_type>( res, res ).release() );
+		}
+
+		return *body();
+	}
+
+	void reset()
+	{
+		auto b = body();
+		if ( !b )
+			return;
+
+		// the signal is unconnected before the slots are destroyed
+		auto res = b->get_memory_resource();
+		state = unconnected( res );
+		resource_delete<body_type>{ res }( b );
+	}
+
+public:
+	signal()
+		: signal( get_default_resource() )
 	{}
-	virtual ~slot() = default;
 
-	slot( slot const& ) = default;
-	slot( slot&& ) = default;
-};
+	explicit signal( memory_resource *res )
+		: state( unconnected( res ) )
+	{}
 
-struct connection
-{
-	struct signal_concept
+	~signal()
 	{
-		void *sig;
-		std::size_t id;
-		bool detached;
-		void *slot_;
+		reset();
+	}
 
-		virtual ~signal_concept()
-		{
-		}
-		virtual void disconnect()
-		{}
-		virtual void block()
-		{}
-		virtual void unblock()
-		{}
-	};
+	signal(signal const&) = delete;
+	signal& operator=(signal const&) = delete;
 
-	template<class Signal>
-	struct signal_reference : signal_concept
+	signal(signal&& other) noexcept
+		: state( other.state )
 	{
-		using slot_type = typename Signal::slot_type;
-		signal_reference(Signal *s, std::size_t i, slot_type *sl)
-		{
-			sig = s;
-			id = i;
-			detached = false;
-			slot_ = sl;
-		}
-		~signal_reference()
-		{
-			if (!detached)
-				disconnect();
-		}
-		void disconnect();
-		void block();
-		void unblock();
-	};
+		other.state = unconnected( get_memory_resource() );
+	}
 
-	struct null_signal : signal_concept
+	signal& operator=(signal&& other) noexcept
 	{
-		null_signal()
-		{
-			sig = nullptr;
-			id = -1;
-			slot_ = nullptr;
-			detached = false;
+		if ( this != &other ) {
+			reset();
+			state = other.state;
+			other.state = unconnected( get_memory_resource() );
 		}
 
-		~null_signal()
-		{}
-	};
+		return *this;
+	}
 
-	std::shared_ptr<signal_concept> concept;
+	memory_resource *get_memory_resource() const
+	{
+		if ( auto b = body() )
+			return b->get_memory_resource();
 
-	template<class Signal>
-	connection(Signal *sig, std::size_t i, typename Signal::slot_type *slot_)
-		: concept( std::make_shared<signal_reference<Signal>>(sig, i, slot_) )
-	{}
+		return reinterpret_cast<memory_resource *>( state & ~std::uintptr_t(1) );
+	}
 
-	connection()
-		: concept( std::make_shared<null_signal>() )
-	{}
+	std::size_t slot_count() const
+	{
+		auto b = body();
+		return b ? b->slot_count() : 0;
+	}
 
-	~connection()
+	template<class... T>
+	connection connect( T&&... t )
 	{
+		return connected_body().connect( std::forward<T>(t)... );
 	}
 
-	bool operator==(const connection& other) const
+	template<class Func>
+	connection connect_batch( Func func )
 	{
-		return ( concept->id == other.concept->id &&
-		         concept.get() == other.concept.get() );
+		return connected_body().connect_batch( std::move( func ) );
 	}
 
-	void disconnect()
+	void disconnect( connection& con )
 	{
-		std::shared_ptr<signal_concept> empty;
-		std::swap( concept, empty );
+		con.disconnect();
 	}
 
-	void detach()
+	void disconnect( std::size_t con_id )
 	{
-		concept->detached = true;
+		if ( auto b = body() )
+			b->disconnect( con_id );
 	}
-};
 
-}
+	void block( std::size_t con_id )
+	{
+		if ( auto b = body() )
+			b->block( con_id );
+	}
 
-namespace std {
-template<>
-struct hash<pac::connection>
-{
-	std::size_t operator()(pac::connection const& con) const
+	void unblock( std::size_t con_id )
 	{
-		return std::hash<std::size_t>()( con.concept->id );
+		if ( auto b = body() )
+			b->unblock( con_id );
 	}
-};
 
-}
+	void stop_emission()
+	{
+		if ( auto b = body() )
+			b->stop_emission();
+	}
 
-namespace pac {
+	template<class... A>
+	results_type emit(A&&... args)
+	{
+		if ( auto b = body() )
+			return b->emit( std::forward<A>(args)... );
 
-template<class Signature>
-struct invoker;
+		return results_type();
+	}
 
-template<class Ret, class... Args>
-struct invoker<Ret(Args...)>
-{
-	using return_type = Ret;
-	using results_type = std::vector<return_type>;
+	template<class... A>
+	void emit_with(sink_type sink, A&&... args)
+	{
+		if ( auto b = body() )
+			b->emit_with( sink, std::forward<A>(args)... );
+	}
 
-	template<class SlotIt, class... A>
-	results_type dispatch(SlotIt beg, SlotIt end, A&&... args)
+	template<template<class> class Combiner, class... A>
+	typename Combiner<Ret>::result_type emit_with(A&&... args)
 	{
-		results_type results;
-		auto it = beg;
+		Combiner<Ret> combiner;
+		return emit_with( combiner, std::forward<A>(args)... );
+	}
 
-		for ( ; it != end; ++it ) {
-			if ( it->second->blocked )
-				continue;
+	template<class Combiner, class... A>
+	auto emit_with(Combiner& combiner, A&&... args)
+		-> typename std::enable_if< is_combiner<Combiner>::value,
+		                            decltype( combiner.result() ) >::type
+	{
+		if ( auto b = body() )
+			return b->emit_with( combiner, std::forward<A>(args)... );
 
-			results.push_back(
-				std::move( it->second->callback( std::forward<A>(args)... ) ) );
-		}
+		return combiner.result();
+	}
 
-		return results;
+	template<class Combiner, class... A>
+	auto emit_with(Combiner&& combiner, A&&... args)
+		-> typename std::enable_if< is_combiner<Combiner>::value &&
+		                            !std::is_reference<Combiner>::value,
+		                            decltype( combiner.result() ) >::type
+	{
+		return emit_with( combiner, std::forward<A>(args)... );
+	}
+
+	template<class Range>
+	void emit_batch( Range const& items )
+	{
+		if ( auto b = body() )
+			b->emit_batch( items );
+	}
+
+	template<class Pool, class... A>
+	results_type emit_parallel(Pool& pool, A&&... args)
+	{
+		if ( auto b = body() )
+			return b->emit_parallel( pool, std::forward<A>(args)... );
+
+		return results_type();
 	}
 };
 
-template<class... Args>
-struct invoker<void(Args...)>
+// Slot of an mt_policy signal.  Snapshots share it, so the flags are
+// atomic: a slot disconnected or blocked on one thread is skipped by
+// emissions still walking an older snapshot on another
+template<class Callback>
+struct shared_slot
 {
-	using return_type = void;
-	using results_type = void;
+	std::atomic<bool> blocked{ false };
+	std::atomic<bool> delete_requested{ false };
+	bool tracked = false;
+	std::size_t id = 0;
+	Callback callback;
+	std::weak_ptr<void> tracker;
+	std::shared_ptr<group_state> group;
 
-	using callback_type = callback<void( Args... )>;
-	using slot_type = slot<callback_type>;
+	shared_slot(Callback cb)
+		: callback( std::move( cb ) )
+	{}
 
-	template<class SlotIt, class... A>
-	return_type dispatch(SlotIt beg, SlotIt end, A&&... args)
+	shared_slot(Callback cb, std::weak_ptr<void> track)
+		: tracked( true ), callback( std::move( cb ) ), tracker( std::move( track ) )
+	{}
+
+	template<class Func>
+	visit_result visit( Func&& func )
 	{
-		auto it = beg;
+		if ( blocked || delete_requested )
+			return visit_result::skipped;
 
-		for ( ; it != end; ++it ) {
-			if ( it->second->blocked )
-				continue;
+		if ( group ) {
+			if ( group->disconnected.load( std::memory_order_relaxed ) )
+				return visit_result::expired;
+
+			if ( group->blocked.load( std::memory_order_relaxed ) )
+				return visit_result::skipped;
+		}
 
-			it->second->callback( std::forward<A>(args)... );
+		if ( !tracked ) {
+			func( callback );
+			return visit_result::invoked;
 		}
 
+		auto guard = tracker.lock();
+		if ( !guard )
+			return visit_result::expired;
+
+		func( callback );
+		return visit_result::invoked;
+	}
+};
+
+// Iterates a range of pointers as the objects they point to
+template<class It>
+struct indirect_iterator
+{
+	It it;
+
+	auto operator*() const -> decltype( **it )
+	{
+		return **it;
+	}
+
+	indirect_iterator& operator++()
+	{
+		++it;
+		return *this;
 	}
 
+	bool operator!=( indirect_iterator const& other ) const
+	{
+		return it != other.it;
+	}
 };
 
+// Emission registers on an emitter count, loads the current slot snapshot,
+// an immutable vector published through an atomic pointer, and walks it
+// without taking the signal's lock or touching a reference count.  connect
+// and disconnect copy the snapshot under the lock and publish the copy; the
+// replaced snapshot is retired and freed once no emission is running,
+// either by the writer or by the last emitter to leave
 template<class Ret, class... Args>
-class signal<Ret(Args...)>
+class signal<Ret(Args...), mt_policy> : connection_target
 {
 public:
 	using results_type = typename invoker<Ret(Args...)>::results_type;
+	using sink_type = typename invoker<Ret(Args...)>::sink_type;
 	using callback_type = callback<Ret( Args... )>;
-	using slot_type = slot<callback_type>;
-
-	friend struct invoker<Ret(Args...)>;
+	using slot_type = shared_slot<callback_type>;
 
 private:
-	std::unordered_map< std::size_t, std::shared_ptr<slot_type> > slots;
+	using slot_ptr = std::shared_ptr<slot_type>;
+	using slot_vector = std::vector< slot_ptr, polymorphic_allocator<slot_ptr> >;
+	using slot_iterator = indirect_iterator<typename slot_vector::const_iterator>;
+
+	struct snapshot_type
+	{
+		slot_vector slots;
+		snapshot_type *next_retired = nullptr;
+
+		explicit snapshot_type( memory_resource *res )
+			: slots( polymorphic_allocator<slot_ptr>( res ) )
+		{}
+	};
+
+	using snapshot_ptr = resource_unique_ptr<snapshot_type>;
+
+	// Keeps the snapshot it loaded alive until the emission is done
+	class reader
+	{
+		signal& sig;
+
+	public:
+		slot_vector const& slots;
+
+		explicit reader( signal& s )
+			: sig( s ),
+			  slots( s.enter().slots )
+		{}
+
+		~reader()
+		{
+			sig.leave();
+		}
+
+		reader( reader const& ) = delete;
+		reader& operator=( reader const& ) = delete;
+	};
+
+	memory_resource *resource;
+
+	// Serializes writers and the freeing of retired snapshots; emission
+	// only ever tries it on the way out
+	mutable std::mutex write_mutex;
 	std::size_t next_id = 0;
-	std::size_t dispatch_depth = 0;
+
+	std::atomic<snapshot_type *> snapshot;
+	std::atomic<std::size_t> emitters{ 0 };
+
+	// Snapshots replaced while emissions were running, guarded by
+	// write_mutex; has_retired lets emitters skip the lock when empty
+	snapshot_type *retired = nullptr;
+	std::atomic<bool> has_retired{ false };
 
 public:
-	signal() = default;
+	signal()
+		: signal( get_default_resource() )
+	{}
 
-	~signal()
+	explicit signal( memory_resource *res )
+		: resource( res ),
+		  snapshot( make_snapshot().release() )
 	{}
 
+	~signal()
+	{
+		release_connections();
+
+		free_snapshots( retired );
+		free_snapshots( snapshot.load( std::memory_order_relaxed ) );
+	}
+
 	signal(signal const&) = delete;
 	signal& operator=(signal const&) = delete;
 
-	signal(signal&&) = default;
-	signal& operator=(signal&&) = default;
+	memory_resource *get_memory_resource() const
+	{
+		return resource;
+	}
 
-	template<class SlotType>
-	connection connect_slot( SlotType const& slot )
+	std::size_t slot_count() const
 	{
+		std::lock_guard<std::mutex> lock( write_mutex );
+		return snapshot.load( std::memory_order_relaxed )->slots.size();
+	}
 
-		auto slotptr = std::make_shared<SlotType>( slot );
-		connection con( this, next_id, slotptr.get() );
+	template<class... T>
+	connection connect( T&&... t )
+	{
+		return connect_slot( make_slot( std::forward<T>(t)... ) );
+	}
 
-		slots.insert( std::make_pair(next_id, slotptr) );
-		++next_id;
-		return con;
+	template<class... T>
+	connection connect( connection_group& group, T&&... t )
+	{
+		auto slot = make_slot( std::forward<T>(t)... );
+		slot->group = group.share();
+		connect_slot( std::move( slot ) ).detach();
+
+		return connection();
 	}
 
 	template<class Signature>
-	connection connect( pac::callback<Signature> cb )
+	slot_ptr make_slot( pac::callback<Signature> cb )
 	{
-		return connect_slot( slot_type(cb) );
+		return std::allocate_shared<slot_type>(
+			polymorphic_allocator<slot_type>( resource ), callback_type( cb ) );
 	}
 
 	template<class Func>
-	connection connect(Func func)
+	slot_ptr make_slot( Func func )
+	{
+		callback_type cb{ std::allocator_arg, resource, std::move( func ) };
+		return std::allocate_shared<slot_type>(
+			polymorphic_allocator<slot_type>( resource ), std::move( cb ) );
+	}
+
+	template<class T, class PMemFunc>
+	slot_ptr make_slot( PMemFunc mfunc, std::weak_ptr<T> obj )
 	{
-		callback_type cb{ func };
-		return connect_slot( slot_type( cb ) );
+		callback_type cb{ std::allocator_arg, resource, mfunc, obj.lock().get() };
+		return std::allocate_shared<slot_type>(
+			polymorphic_allocator<slot_type>( resource ),
+			std::move( cb ), std::move( obj ) );
 	}
 
 	template<class T, class PMemFunc>
-	connection connect( PMemFunc mfunc, T&& obj )
+	slot_ptr make_slot( PMemFunc mfunc, T&& obj )
 	{
-		callback_type cb{ mfunc, obj };
-		return connect_slot( slot_type( cb ) );
+		callback_type cb{ std::allocator_arg, resource, mfunc, std::forward<T>(obj) };
+		return std::allocate_shared<slot_type>(
+			polymorphic_allocator<slot_type>( resource ), std::move( cb ) );
 	}
 
 	void disconnect( connection& con )
@@ -280,111 +1990,228 @@ public:
 
 	void disconnect( std::size_t con_id )
 	{
-		auto it = slots.find( con_id );
-		if ( it == std::end( slots ) )
-			return;
+		snapshot_type *stale = nullptr;
+
+		{
+			std::lock_guard<std::mutex> lock( write_mutex );
+
+			auto& current = snapshot.load( std::memory_order_relaxed )->slots;
+			auto next = make_snapshot();
+			auto& slots = next->slots;
+
+			slots.reserve( current.size() );
+
+			for ( auto const& slot : current ) {
+				if ( slot->id == con_id )
+					slot->delete_requested = true;
+				else
+					slots.push_back( slot );
+			}
+
+			if ( slots.size() != current.size() )
+				stale = publish( std::move( next ) );
+		}
+
+		free_snapshots( stale );
+	}
+
+	void block( std::size_t con_id )
+	{
+		std::lock_guard<std::mutex> lock( write_mutex );
+
+		if ( auto slot = find_slot( con_id ) )
+			slot->blocked = true;
+	}
 
-		if ( dispatch_depth > 0 )
-			it->second->delete_requested = true;
-		else
-			slots.erase( it );
+	void unblock( std::size_t con_id )
+	{
+		std::lock_guard<std::mutex> lock( write_mutex );
 
+		if ( auto slot = find_slot( con_id ) )
+			slot->blocked = false;
 	}
 
 	template<class... A>
 	results_type emit(A&&... args)
 	{
-		invoker<Ret(Args...)> inv;
+		reader current( *this );
 
-		scoped_dec<std::size_t> dec( ++dispatch_depth );
-		scoped_cleanup<decltype(*this)> cleanup_deleted_slots( *this );
+		auto expire = [this]( std::size_t id ) { disconnect( id ); };
+		invoker<Ret(Args...)> inv( expire );
 
-		auto it = slots.begin();
-		auto end = slots.end();
+		return inv.dispatch( slot_iterator{ current.slots.begin() },
+		                     slot_iterator{ current.slots.end() },
+		                     std::forward<A>(args)... );
+	}
 
-		return inv.dispatch( it, end, std::forward<A>(args)... );
+	template<class... A>
+	void emit_with(sink_type sink, A&&... args)
+	{
+		reader current( *this );
+
+		auto expire = [this]( std::size_t id ) { disconnect( id ); };
+		invoker<Ret(Args...)> inv( expire );
+
+		inv.dispatch_with( sink,
+		                   slot_iterator{ current.slots.begin() },
+		                   slot_iterator{ current.slots.end() },
+		                   std::forward<A>(args)... );
+	}
+
+	template<template<class> class Combiner, class... A>
+	typename Combiner<Ret>::result_type emit_with(A&&... args)
+	{
+		Combiner<Ret> combiner;
+		return emit_with( combiner, std::forward<A>(args)... );
+	}
+
+	template<class Combiner, class... A>
+	auto emit_with(Combiner& combiner, A&&... args)
+		-> typename std::enable_if< is_combiner<Combiner>::value,
+		                            decltype( combiner.result() ) >::type
+	{
+		reader current( *this );
+
+		auto expire = [this]( std::size_t id ) { disconnect( id ); };
+		invoker<Ret(Args...)> inv( expire );
+
+		inv.dispatch_combine( combiner,
+		                      slot_iterator{ current.slots.begin() },
+		                      slot_iterator{ current.slots.end() },
+		                      std::forward<A>(args)... );
+
+		return combiner.result();
+	}
+
+	template<class Combiner, class... A>
+	auto emit_with(Combiner&& combiner, A&&... args)
+		-> typename std::enable_if< is_combiner<Combiner>::value &&
+		                            !std::is_reference<Combiner>::value,
+		                            decltype( combiner.result() ) >::type
+	{
+		return emit_with( combiner, std::forward<A>(args)... );
 	}
 
 private:
-	template<class T>
-	struct scoped_dec
+	static connection_ops const& ops()
 	{
-		T& obj;
+		static const connection_ops table{
+			[]( connection_target *sig, std::size_t id )
+			{ static_cast<signal *>( sig )->disconnect( id ); },
+			[]( connection_target *sig, std::size_t id )
+			{ static_cast<signal *>( sig )->block( id ); },
+			[]( connection_target *sig, std::size_t id )
+			{ static_cast<signal *>( sig )->unblock( id ); } };
+
+		return table;
+	}
 
-		scoped_dec(T& obj_)
-			: obj(obj_)
-		{}
+	snapshot_ptr make_snapshot()
+	{
+		return allocate_unique<snapshot_type>( resource, resource );
+	}
 
-		~scoped_dec()
-		{
-			--obj;
-		}
-	};
+	// The emitter count is incremented before the snapshot is loaded, and
+	// writers exchange the snapshot before reading the count, both
+	// sequentially consistent: a writer that sees no emitters knows every
+	// later emission loads its snapshot rather than a retired one
+	snapshot_type const& enter()
+	{
+		emitters.fetch_add( 1 );
+		return *snapshot.load();
+	}
 
-	template<class Signal>
-	struct scoped_cleanup
+	void leave()
 	{
-		Signal& sig;
-		scoped_cleanup(Signal& sig_)
-			: sig(sig_)
-		{}
+		if ( emitters.fetch_sub( 1 ) != 1 ||
+		     !has_retired.load( std::memory_order_relaxed ) )
+			return;
 
-		~scoped_cleanup()
-		{
-			auto it = sig.slots.begin();
-			auto end = sig.slots.end();
+		// A writer holding the lock frees the retired snapshots itself, or
+		// leaves them to the next emission
+		snapshot_type *stale = nullptr;
 
-			for( ; it != end; ++it ) {
-				if ( it->second->delete_requested )
-					it = sig.slots.erase( it );
-			}
+		{
+			std::unique_lock<std::mutex> lock( write_mutex, std::try_to_lock );
+			if ( lock.owns_lock() )
+				stale = reclaim();
 		}
-	};
 
-	friend struct scoped_cleanup< signal<Ret(Args...)> >;
-};
+		free_snapshots( stale );
+	}
 
-template<class Signal>
-void connection::signal_reference<Signal>::disconnect()
-{
+	// Called with write_mutex held; returns the snapshots that may be freed
+	// once it is released, since freeing a slot may disconnect others
+	snapshot_type *publish( snapshot_ptr next )
+	{
+		auto old = snapshot.exchange( next.release() );
 
-	Signal *real_sig = static_cast<Signal *>(sig);
+		old->next_retired = retired;
+		retired = old;
+		has_retired.store( true, std::memory_order_relaxed );
 
-	if (!real_sig) {
-		return;
+		return reclaim();
 	}
 
-	real_sig->disconnect( id );
-}
-
-template<class Signal>
-void connection::signal_reference<Signal>::block()
-{
+	// Called with write_mutex held
+	snapshot_type *reclaim()
+	{
+		if ( !retired || emitters.load() != 0 )
+			return nullptr;
 
-	using slot_type = typename Signal::slot_type;
+		auto stale = retired;
+		retired = nullptr;
+		has_retired.store( false, std::memory_order_relaxed );
 
-	slot_type *real_slot = static_cast<slot_type *>(slot_);
+		return stale;
+	}
 
-	if (!real_slot) {
-		return;
+	void free_snapshots( snapshot_type *list )
+	{
+		while ( list ) {
+			auto next = list->next_retired;
+			resource_delete<snapshot_type>{ resource }( list );
+			list = next;
+		}
 	}
 
-	real_slot->blocked = true;
-}
+	connection connect_slot( slot_ptr slot )
+	{
+		snapshot_type *stale;
+		connection con;
 
-template<class Signal>
-void connection::signal_reference<Signal>::unblock()
-{
-	using slot_type = typename Signal::slot_type;
+		{
+			std::lock_guard<std::mutex> lock( write_mutex );
+
+			slot->id = next_id++;
+
+			auto& current = snapshot.load( std::memory_order_relaxed )->slots;
+			auto next = make_snapshot();
+			auto& slots = next->slots;
+
+			slots.reserve( current.size() + 1 );
+			slots.insert( slots.end(), current.begin(), current.end() );
+			slots.push_back( slot );
 
-	slot_type *real_slot = static_cast<slot_type *>(slot_);
+			stale = publish( std::move( next ) );
+			con = make_connection( ops(), slot->id );
+		}
+
+		free_snapshots( stale );
 
-	if (!real_slot) {
-		return;
+		return con;
 	}
 
-	real_slot->blocked = false;
-}
+	// Called with write_mutex held, so the current snapshot stays put
+	slot_ptr find_slot( std::size_t con_id ) const
+	{
+		for ( auto const& slot : snapshot.load( std::memory_order_relaxed )->slots )
+			if ( slot->id == con_id )
+				return slot;
+
+		return nullptr;
+	}
+};
 
 struct connection_block
 {
@@ -393,12 +2220,12 @@ struct connection_block
 	connection_block(connection& c)
 		: con(c)
 	{
-		con.concept->block();
+		con.block();
 	}
 
 	~connection_block()
 	{
-		con.concept->unblock();
+		con.unblock();
 	}
 };
 
@@ -0,0 +1,102 @@
+/*
+ * This file is part of PAC
+ *
+ * PAC is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * PAC is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with PAC.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef PAC_SPAN_HPP
+#define PAC_SPAN_HPP
+
+#include <cstddef>
+#include <type_traits>
+#include <utility>
+
+namespace pac {
+
+// Non-owning view of a contiguous sequence; a subset of C++20 std::span
+template<class T>
+class span
+{
+	T *ptr = nullptr;
+	std::size_t count = 0;
+
+public:
+	using element_type = T;
+	using value_type = typename std::remove_cv<T>::type;
+	using iterator = T *;
+
+	span() = default;
+
+	span( T *p, std::size_t n )
+		: ptr( p ), count( n )
+	{}
+
+	template<std::size_t N>
+	span( T (&arr)[N] )
+		: ptr( arr ), count( N )
+	{}
+
+	// Any container exposing data() and size(), e.g. std::vector
+	template<class Container,
+	         class = typename std::enable_if<
+		         std::is_convertible<
+			         decltype( std::declval<Container&>().data() ), T * >::value
+		         >::type>
+	span( Container& c )
+		: ptr( c.data() ), count( c.size() )
+	{}
+
+	// span<T> converts to span<T const>
+	template<class U,
+	         class = typename std::enable_if<
+		         std::is_convertible<U *, T *>::value >::type>
+	span( span<U> const& other )
+		: ptr( other.data() ), count( other.size() )
+	{}
+
+	T *data() const
+	{
+		return ptr;
+	}
+
+	std::size_t size() const
+	{
+		return count;
+	}
+
+	bool empty() const
+	{
+		return count == 0;
+	}
+
+	T& operator[]( std::size_t i ) const
+	{
+		return ptr[i];
+	}
+
+	iterator begin() const
+	{
+		return ptr;
+	}
+
+	iterator end() const
+	{
+		return ptr + count;
+	}
+};
+
+} // namespace pac
+
+#endif // PAC_SPAN_HPP
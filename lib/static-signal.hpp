@@ -0,0 +1,162 @@
+/*
+ * This file is part of PAC
+ *
+ * PAC is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * PAC is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with PAC.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef PAC_STATIC_SIGNAL_HPP
+#define PAC_STATIC_SIGNAL_HPP
+
+#include <array>
+#include <cstddef>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+#include "combiner.hpp"
+
+namespace pac {
+
+template<class Signature, class... Slots>
+class static_signal;
+
+// Signal whose receivers are fixed at compile time, for wiring that never
+// changes at runtime.  The slots are stored by value in a tuple and called
+// directly in order, so the compiler sees through the whole dispatch and
+// can inline it as if the handlers were called by hand.  There is nothing
+// to connect or disconnect at runtime; connect builds a new signal with
+// one more slot
+template<class Ret, class... Args, class... Slots>
+class static_signal<Ret(Args...), Slots...>
+{
+	template<class Signature, class... Other>
+	friend class static_signal;
+
+	using indices = std::make_index_sequence< sizeof...(Slots) >;
+
+	std::tuple<Slots...> slots;
+
+public:
+	// One result per slot, in slot order
+	using results_type = typename std::conditional<
+		std::is_void<Ret>::value,
+		void,
+		std::array< typename std::conditional< std::is_void<Ret>::value, int, Ret >::type,
+		            sizeof...(Slots) > >::type;
+
+	explicit static_signal( Slots... s )
+		: slots( std::move( s )... )
+	{}
+
+	static constexpr std::size_t slot_count()
+	{
+		return sizeof...(Slots);
+	}
+
+	template<std::size_t I>
+	auto slot() -> typename std::tuple_element< I, std::tuple<Slots...> >::type&
+	{
+		return std::get<I>( slots );
+	}
+
+	template<class Func>
+	static_signal<Ret(Args...), Slots..., Func> connect( Func func ) const&
+	{
+		return extend( std::move( func ), indices() );
+	}
+
+	template<class Func>
+	static_signal<Ret(Args...), Slots..., Func> connect( Func func ) &&
+	{
+		return std::move( *this ).extend( std::move( func ), indices() );
+	}
+
+	template<class... A>
+	results_type emit( A&&... args )
+	{
+		return dispatch( std::is_void<Ret>(), indices(), args... );
+	}
+
+	// Feed the results to combiner, stopping at the first slot it declines
+	template<class Combiner, class... A>
+	auto emit_with( Combiner& combiner, A&&... args )
+		-> typename std::enable_if< is_combiner<Combiner>::value,
+		                            decltype( combiner.result() ) >::type
+	{
+		combine( combiner, indices(), args... );
+		return combiner.result();
+	}
+
+	template<template<class> class Combiner, class... A>
+	typename Combiner<Ret>::result_type emit_with( A&&... args )
+	{
+		Combiner<Ret> combiner;
+		return emit_with( combiner, std::forward<A>(args)... );
+	}
+
+private:
+	using expand = int[];
+
+	template<class Func, std::size_t... I>
+	static_signal<Ret(Args...), Slots..., Func>
+	extend( Func func, std::index_sequence<I...> ) const&
+	{
+		return static_signal<Ret(Args...), Slots..., Func>(
+			std::get<I>( slots )..., std::move( func ) );
+	}
+
+	template<class Func, std::size_t... I>
+	static_signal<Ret(Args...), Slots..., Func>
+	extend( Func func, std::index_sequence<I...> ) &&
+	{
+		return static_signal<Ret(Args...), Slots..., Func>(
+			std::move( std::get<I>( slots ) )..., std::move( func ) );
+	}
+
+	// Braced initializers evaluate in order, so slots run in connection
+	// order
+	template<std::size_t... I, class... A>
+	void dispatch( std::true_type, std::index_sequence<I...>, A&... args )
+	{
+		(void)expand{ 0, ( (void)std::get<I>( slots )( args... ), 0 )... };
+	}
+
+	template<std::size_t... I, class... A>
+	results_type dispatch( std::false_type, std::index_sequence<I...>, A&... args )
+	{
+		return results_type{ { std::get<I>( slots )( args... )... } };
+	}
+
+	template<class Combiner, std::size_t... I, class... A>
+	void combine( Combiner& combiner, std::index_sequence<I...>, A&... args )
+	{
+		bool more = true;
+		(void)expand{ 0, ( more = more && combiner( std::get<I>( slots )( args... ) ), 0 )... };
+	}
+};
+
+// make_static_signal<void(int)>( on_click, log_click ) connects on_click
+// and log_click in that order
+template<class Signature, class... Slots>
+static_signal<Signature, typename std::decay<Slots>::type...>
+make_static_signal( Slots&&... slots )
+{
+	return static_signal<Signature, typename std::decay<Slots>::type...>(
+		std::forward<Slots>(slots)... );
+}
+
+} // namespace pac
+
+#endif // PAC_STATIC_SIGNAL_HPP
@@ -0,0 +1,75 @@
+/*
+ * This file is part of PAC
+ *
+ * PAC is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * PAC is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with PAC.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef PAC_TOE_POOL_HPP
+#define PAC_TOE_POOL_HPP
+
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "context.hpp"
+
+namespace pac {
+
+// A fixed set of toes, each running on its own thread, used as workers by
+// signal::emit_parallel
+class toe_pool
+{
+	std::vector<toe> toes;
+
+public:
+	explicit toe_pool( std::size_t n = std::thread::hardware_concurrency() )
+		: toes( n ? n : 1 )
+	{
+		for ( auto& t : toes )
+			t.launch( toe::launch_type::async );
+	}
+
+	~toe_pool()
+	{
+		for ( auto& t : toes )
+			t.quit();
+
+		for ( auto& t : toes )
+			t.join();
+	}
+
+	toe_pool( toe_pool const& ) = delete;
+	toe_pool& operator=( toe_pool const& ) = delete;
+
+	std::size_t size() const
+	{
+		return toes.size();
+	}
+
+	toe& operator[]( std::size_t i )
+	{
+		return toes[i];
+	}
+
+	template<class Callback>
+	void post( std::size_t i, Callback callback )
+	{
+		toes[i % toes.size()].add_callback( std::move( callback ) );
+	}
+};
+
+} // namespace pac
+
+#endif // PAC_TOE_POOL_HPP
@@ -155,7 +155,7 @@ struct RootController
 	{
 		connections.push_back(
 			pre->SignalButtonClicked().connect(
-				&RootController::OnButtonClicked, this ) );
+				PAC_DELEGATE( &RootController::OnButtonClicked, this ) ) );
 	}
 
 	void OnButtonClicked()
@@ -0,0 +1,196 @@
+#include "callback.hpp"
+#include "signal.hpp"
+#include "signal-forward.hpp"
+#include "context.hpp"
+
+#include <atomic>
+#include <cassert>
+#include <chrono>
+#include <iostream>
+#include <thread>
+
+// Counts every copy and move made of it (and of anything copied from it)
+struct counted
+{
+	static std::atomic<int> copies;
+	static std::atomic<int> moves;
+
+	int value;
+
+	counted( int v = 0 )
+		: value( v )
+	{}
+
+	counted( counted const& other )
+		: value( other.value )
+	{
+		++copies;
+	}
+
+	counted( counted&& other )
+		: value( other.value )
+	{
+		++moves;
+	}
+
+	counted& operator=( counted const& other )
+	{
+		value = other.value;
+		++copies;
+		return *this;
+	}
+
+	counted& operator=( counted&& other )
+	{
+		value = other.value;
+		++moves;
+		return *this;
+	}
+
+	static void reset()
+	{
+		copies = 0;
+		moves = 0;
+	}
+};
+
+std::atomic<int> counted::copies{ 0 };
+std::atomic<int> counted::moves{ 0 };
+
+void callback_hop_test()
+{
+	counted c( 1 );
+	int seen = 0;
+
+	// by reference: never copied
+	pac::callback< void( counted const& ) > cref(
+		[&seen]( counted const& x ) { seen = x.value; } );
+	counted::reset();
+	cref( c );
+	assert( counted::copies == 0 && counted::moves == 0 );
+
+	// by value from an lvalue: one copy on entry, one move into the target
+	pac::callback< void( counted ) > cval(
+		[&seen]( counted x ) { seen = x.value; } );
+	counted::reset();
+	cval( c );
+	assert( counted::copies == 1 && counted::moves == 1 );
+
+	// by value from an rvalue: no copies at all
+	counted::reset();
+	cval( counted( 2 ) );
+	assert( counted::copies == 0 && counted::moves == 1 );
+	assert( seen == 2 );
+}
+
+void signal_hop_test()
+{
+	counted c( 3 );
+	int seen = 0;
+
+	pac::signal< void( counted const& ) > sref;
+	auto con1 = sref.connect( [&seen]( counted const& x ) { seen += x.value; } );
+	auto con2 = sref.connect( [&seen]( counted const& x ) { seen += x.value; } );
+
+	counted::reset();
+	sref.emit( c );
+	assert( counted::copies == 0 && counted::moves == 0 );
+	assert( seen == 6 );
+
+	// every by-value slot gets its own copy, even when emitting an rvalue
+	pac::signal< void( counted ) > sval;
+	auto con3 = sval.connect( [&seen]( counted x ) { seen += x.value; } );
+	auto con4 = sval.connect( [&seen]( counted x ) { seen += x.value; } );
+
+	counted::reset();
+	sval.emit( std::move( c ) );
+	assert( counted::copies == 2 && counted::moves == 2 );
+	assert( seen == 12 );
+}
+
+void forward_hop_test()
+{
+	counted c( 4 );
+
+	pac::signal< int( counted const& ) > sig;
+	pac::signal_forward< decltype( sig ), int( counted const& ) > fwd( sig );
+	pac::signal_forward< decltype( fwd ), int( counted const& ) > fwd2( fwd );
+
+	auto con1 = fwd.connect( []( counted const& x ) { return x.value; } );
+	auto con2 = fwd2.connect( []( counted const& x ) { return x.value * 2; } );
+
+	counted::reset();
+	auto results = sig.emit( c );
+	assert( counted::copies == 0 && counted::moves == 0 );
+	assert( results.size() == 2 && results[0] + results[1] == 12 );
+}
+
+void runnable_hop_test()
+{
+	counted c( 5 );
+	int seen = 0;
+
+	pac::context ctxt;
+	pac::callback< void( counted const& ) > cb(
+		[&seen]( counted const& x ) { seen = x.value; } );
+
+	// copied once into the runnable, then handed over by reference
+	counted::reset();
+	ctxt.add_callback( cb, c );
+	ctxt.next_runnable().run();
+	assert( counted::copies == 1 && counted::moves == 0 );
+	assert( seen == 5 );
+
+	// a run once runnable moves its arguments into the callback
+	pac::callback< void( counted ) > cbval(
+		[&seen]( counted x ) { seen = x.value + 1; } );
+
+	counted::reset();
+	ctxt.add_callback( cbval, c );
+	ctxt.next_runnable().run();
+	assert( counted::copies == 1 && counted::moves == 2 );
+	assert( seen == 6 );
+}
+
+void toe_hop_test()
+{
+	counted c( 7 );
+	std::atomic<int> seen{ 0 };
+
+	pac::toe toe;
+	toe.launch( pac::toe::launch_type::async );
+
+	pac::signal< void( counted const& ) > sig;
+	auto con = sig.connect(
+		pac::toe_callback( toe, pac::callback< void( counted const& ) >(
+			                   [&seen]( counted const& x ) { seen = x.value; } ) ) );
+
+	// the only copy is made when the argument crosses to the toe
+	counted::reset();
+	sig.emit( c );
+
+	for ( int i = 0; i < 200 && seen == 0; ++i )
+		std::this_thread::sleep_for( std::chrono::milliseconds( 5 ) );
+
+	assert( seen == 7 );
+	assert( counted::copies == 1 && counted::moves == 0 );
+
+	toe.quit();
+}
+
+int main(int argc, char *argv[])
+{
+	callback_hop_test();
+
+	signal_hop_test();
+
+	forward_hop_test();
+
+	runnable_hop_test();
+
+	toe_hop_test();
+
+	std::cout << "Success: All tests passed!\n";
+
+	return 0;
+}
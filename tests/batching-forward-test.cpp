@@ -0,0 +1,121 @@
+#include "batching-forward.hpp"
+
+#include <cassert>
+#include <chrono>
+#include <future>
+#include <iostream>
+#include <set>
+#include <vector>
+
+struct sample
+{
+	int channel;
+	double value;
+};
+
+// Wait for everything posted to toe so far to run
+void drain( pac::toe& toe )
+{
+	std::promise<void> done;
+	toe.add_callback( pac::callback<void()>( [&done]() { done.set_value(); } ) );
+	done.get_future().wait();
+}
+
+void threshold_and_deadline_test()
+{
+	pac::toe toe;
+	pac::signal<void(sample)> samples;
+	pac::batching_forward< decltype( samples ) > batches( samples, toe, 4, 20000 );
+
+	std::vector< std::vector<int> > received;
+	std::set<sample const *> buffers;
+	std::promise<void> remainder;
+	std::promise<void> late_batch;
+
+	auto con = batches.connect(
+		[&]( pac::span<sample const> batch )
+		{
+			std::vector<int> channels;
+			for ( auto const& s : batch )
+				channels.push_back( s.channel );
+
+			received.push_back( channels );
+			buffers.insert( batch.data() );
+
+			if ( channels.back() == 9 )
+				remainder.set_value();
+			if ( channels.back() == 12 )
+				late_batch.set_value();
+		} );
+
+	// the toe is not running yet, but a burst is still cut into batches of
+	// at most the threshold
+	for ( int i = 0; i < 10; ++i )
+		samples.emit( sample{ i, i * 0.5 } );
+
+	toe.launch( pac::toe::launch_type::async );
+
+	// below the threshold the deadline delivers the rest
+	auto status = remainder.get_future().wait_for( std::chrono::seconds( 5 ) );
+	assert( status == std::future_status::ready );
+	assert( received.size() == 3 );
+	assert( ( received[0] == std::vector<int>{ 0, 1, 2, 3 } ) );
+	assert( ( received[1] == std::vector<int>{ 4, 5, 6, 7 } ) );
+	assert( ( received[2] == std::vector<int>{ 8, 9 } ) );
+
+	samples.emit( sample{ 11, 0.0 } );
+	samples.emit( sample{ 12, 0.0 } );
+
+	status = late_batch.get_future().wait_for( std::chrono::seconds( 5 ) );
+	assert( status == std::future_status::ready );
+	assert( received.size() == 4 );
+	assert( ( received[3] == std::vector<int>{ 11, 12 } ) );
+
+	// an explicit flush does not wait for either
+	samples.emit( sample{ 13, 0.0 } );
+	batches.flush();
+	drain( toe );
+	assert( received.size() == 5 && received[4][0] == 13 );
+
+	// full batches delivered one at a time reuse the same buffers
+	for ( int burst = 0; burst < 10; ++burst ) {
+		for ( int i = 0; i < 4; ++i )
+			samples.emit( sample{ 100 + i, 0.0 } );
+		drain( toe );
+	}
+	assert( received.size() == 15 );
+	assert( buffers.size() <= 4 );
+
+	toe.quit();
+	toe.join();
+}
+
+void timeout_order_test()
+{
+	pac::toe toe;
+	std::vector<int> order;
+	std::promise<void> done;
+
+	toe.add_timeout( 30000, pac::callback<void()>( [&]() { order.push_back( 3 ); done.set_value(); } ) );
+	toe.add_timeout( 10000, pac::callback<void()>( [&]() { order.push_back( 2 ); } ) );
+	toe.add_callback( pac::callback<void()>( [&]() { order.push_back( 1 ); } ) );
+
+	toe.launch( pac::toe::launch_type::async );
+	done.get_future().wait();
+
+	assert( ( order == std::vector<int>{ 1, 2, 3 } ) );
+
+	toe.quit();
+	toe.join();
+}
+
+int main(int argc, char *argv[])
+{
+	timeout_order_test();
+
+	threshold_and_deadline_test();
+
+	std::cout << "Success: All tests passed!\n";
+
+	return 0;
+}
@@ -233,6 +233,113 @@ void scope_test()
 	assert( holder.success == 1 );
 }
 
+void storage_test()
+{
+	// small callables are stored inline, large and move-only ones on the heap
+	int base = 3;
+	pac::callback< int( int ) > small( [base]( int x ) { return base + x; } );
+
+	long big[16] = { 7 };
+	pac::callback< int( int ) > large( [big]( int x ) { return big[0] + x; } );
+
+	std::unique_ptr<int> owned( new int( 11 ) );
+	auto p = owned.get();
+	pac::callback< int( int ) > moveonly(
+		[owned = std::move( owned )]( int x ) { return *owned + x; } );
+
+	auto small2 = small;
+	auto large2 = large;
+	auto moveonly2 = moveonly;
+
+	assert( small( 1 ) == 4 && small2( 1 ) == 4 );
+	assert( large( 1 ) == 8 && large2( 1 ) == 8 );
+	assert( moveonly( 1 ) == 12 && moveonly2( 1 ) == 12 && *p == 11 );
+
+	auto small3 = std::move( small );
+	assert( !small && small3 );
+	assert( small3( 2 ) == 5 );
+	assert( small( 2 ) == 0 );
+
+	small = large2;
+	assert( small( 1 ) == 8 );
+}
+
+int call_through( pac::callback_ref< int( int, int ) > ref )
+{
+	return ref( 1, 1 );
+}
+
+void callback_ref_test()
+{
+	Foo f;
+	pac::callback< int( int, int ) > cb( &Foo::Bar, &f );
+	auto func = [](int x, int y) { return x + y + 200; };
+	int calls = 0;
+
+	assert( call_through( foo ) == foo( 1, 1 ) );
+	assert( call_through( cb ) == f.Bar( 1, 1 ) );
+	assert( call_through( func ) == func( 1, 1 ) );
+	assert( call_through( [&calls](int x, int y) { return ++calls + x + y; } ) == 3 );
+	assert( calls == 1 );
+
+	pac::callback_ref< int( int, int ) > ref( cb );
+	pac::callback_ref< int( int, int ) > ref2 = ref;
+	assert( ref2( 2, 2 ) == f.Bar( 2, 2 ) );
+}
+
+void unique_callback_test()
+{
+	std::unique_ptr<int> owned( new int( 42 ) );
+	pac::unique_callback< int( int ) > cb(
+		[owned = std::move( owned )]( int x ) { return *owned + x; } );
+
+	assert( cb( 1 ) == 43 );
+
+	auto cb2 = std::move( cb );
+	assert( !cb && cb2 );
+	assert( cb2( 2 ) == 44 );
+
+	Foo f;
+	pac::unique_callback< int( int, int ) > cb3( &Foo::Bar, &f );
+	assert( cb3( 1, 1 ) == f.Bar( 1, 1 ) );
+
+	long big[16] = { 5 };
+	std::unique_ptr<long> owned2( new long( 6 ) );
+	pac::unique_callback< long() > cb4(
+		[big, owned2 = std::move( owned2 )]() { return big[0] + *owned2; } );
+	auto cb5 = std::move( cb4 );
+	assert( cb5() == 11 );
+}
+
+void delegate_test()
+{
+	Foo f;
+	auto d = PAC_DELEGATE( &Foo::Bar, &f );
+
+	static_assert( std::is_trivially_copyable< decltype( d ) >::value,
+	               "delegate must be trivially copyable" );
+	static_assert( sizeof( d ) == 2 * sizeof( void * ),
+	               "delegate must be an object pointer and a thunk" );
+
+	assert( d( 1, 1 ) == f.Bar( 1, 1 ) );
+
+	auto d2 = d;
+	assert( d2 == d );
+
+	pac::callback< int( int, int ) > cb( d );
+	assert( cb( 2, 3 ) == f.Bar( 2, 3 ) );
+
+	base b;
+	derived dv;
+	auto vd1 = PAC_DELEGATE( &base::op, &b );
+	auto vd2 = PAC_DELEGATE( &base::op, &dv );
+	assert( vd1() == b.op() );
+	assert( vd2() == dv.op() );
+
+	pac::delegate< int() > empty;
+	assert( !empty && empty() == 0 );
+}
+
 int main(int argc, char *argv[])
 {
 	basic_func();
@@ -253,6 +360,14 @@ int main(int argc, char *argv[])
 
 	scope_test();
 
+	storage_test();
+
+	callback_ref_test();
+
+	unique_callback_test();
+
+	delegate_test();
+
 	std::cout << "Success: All tests passed!\n";
 
 	return 0;
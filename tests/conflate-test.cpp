@@ -0,0 +1,85 @@
+#include "conflate.hpp"
+#include "signal.hpp"
+
+#include <cassert>
+#include <future>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// Wait for everything posted to toe so far to run
+void drain( pac::toe& toe )
+{
+	std::promise<void> done;
+	toe.add_callback( pac::callback<void()>( [&done]() { done.set_value(); } ) );
+	done.get_future().wait();
+}
+
+void conflate_test()
+{
+	pac::toe toe;
+	std::vector<int> received;
+
+	pac::signal<void(int)> progress;
+	auto con = progress.connect(
+		pac::conflate( toe, pac::callback<void(int)>(
+			               [&received]( int percent ) { received.push_back( percent ); } ) ) );
+
+	// the toe is not running yet: a burst collapses into one delivery
+	for ( int i = 0; i <= 100; ++i )
+		progress.emit( i );
+
+	toe.launch( pac::toe::launch_type::async );
+	drain( toe );
+
+	assert( ( received == std::vector<int>{ 100 } ) );
+
+	progress.emit( 7 );
+	drain( toe );
+	assert( ( received == std::vector<int>{ 100, 7 } ) );
+
+	toe.quit();
+	toe.join();
+}
+
+void conflate_by_key_test()
+{
+	pac::toe toe;
+	std::vector<std::string> received;
+
+	pac::signal<void(std::string const&, int)> sensor;
+	auto con = sensor.connect(
+		pac::conflate_by_key(
+			toe,
+			[]( std::string const& name, int ) { return name; },
+			pac::callback<void(std::string const&, int)>(
+				[&received]( std::string const& name, int value )
+				{
+					received.push_back( name + "=" + std::to_string( value ) );
+				} ) ) );
+
+	sensor.emit( "temp", 20 );
+	sensor.emit( "humidity", 40 );
+	sensor.emit( "temp", 21 );
+	sensor.emit( "temp", 22 );
+	sensor.emit( "humidity", 41 );
+
+	toe.launch( pac::toe::launch_type::async );
+	drain( toe );
+
+	assert( ( received == std::vector<std::string>{ "temp=22", "humidity=41" } ) );
+
+	toe.quit();
+	toe.join();
+}
+
+int main(int argc, char *argv[])
+{
+	conflate_test();
+
+	conflate_by_key_test();
+
+	std::cout << "Success: All tests passed!\n";
+
+	return 0;
+}
@@ -6,6 +6,8 @@
 #include <iostream>
 #include <thread>
 
+#include <cassert>
+
 int donk( int x )
 {
 	std::cout << "x = " << x << "\n";
@@ -137,10 +139,66 @@ void toe_callback_test()
 	}
 }
 
+void unique_callback_runnable_test()
+{
+	pac::context ctxt;
+	int result = 0;
+
+	std::unique_ptr<int> payload( new int( 99 ) );
+	pac::unique_callback<void( std::unique_ptr<int> const& )> cb(
+		[&result]( std::unique_ptr<int> const& p ) { result = *p; } );
+
+	ctxt.add_callback( std::move( cb ), std::move( payload ) );
+	assert( ctxt.runnable_count() == 1 );
+
+	auto run = ctxt.next_runnable();
+	assert( run.run() == pac::runnable_status::FINISHED );
+	assert( result == 99 );
+
+	pac::signal<void( int )> sig;
+	std::unique_ptr<int> offset( new int( 1 ) );
+	auto con = sig.connect(
+		pac::unique_callback<void( int )>(
+			[&result, offset = std::move( offset )]( int x ) { result = x + *offset; } ) );
+
+	sig.emit( 5 );
+	assert( result == 6 );
+}
+
+struct counter
+{
+	int count = 0;
+
+	void bump( int n )
+	{
+		count += n;
+	}
+};
+
+void delegate_runnable_test()
+{
+	counter c;
+	pac::context ctxt;
+	pac::signal<void( int )> sig;
+
+	auto d = PAC_DELEGATE( &counter::bump, &c );
+	auto con = sig.connect( d );
+	ctxt.add_callback( d, 2 );
+
+	sig.emit( 3 );
+	ctxt.next_runnable().run();
+
+	assert( c.count == 5 );
+}
+
 int main(int argc, char *argv[])
 {
 	basic_runnable_test();
 
+	unique_callback_runnable_test();
+
+	delegate_runnable_test();
+
 	football_test();
 
 	toe_callback_test();
@@ -0,0 +1,152 @@
+#include "event-bus.hpp"
+
+#include <cassert>
+#include <future>
+#include <iostream>
+#include <string>
+#include <thread>
+
+struct button_clicked
+{
+	int button;
+};
+
+struct title_changed
+{
+	std::string title;
+};
+
+struct root_presentation
+{
+	int clicks = 0;
+	std::string title;
+
+	void OnButtonClicked( button_clicked const& e )
+	{
+		clicks += e.button;
+	}
+};
+
+void dispatch_test()
+{
+	pac::event_bus bus;
+	root_presentation pres;
+
+	auto c1 = bus.subscribe<button_clicked>( &root_presentation::OnButtonClicked, &pres );
+	auto c2 = bus.subscribe<title_changed>(
+		[&pres]( title_changed const& e ) { pres.title = e.title; } );
+
+	bus.publish( button_clicked{ 1 } );
+	bus.publish( button_clicked{ 2 } );
+	bus.publish( title_changed{ "PAC" } );
+
+	assert( pres.clicks == 3 );
+	assert( pres.title == "PAC" );
+
+	// events without subscribers go nowhere
+	struct unheard
+	{};
+	bus.publish( unheard{} );
+	assert( bus.subscriber_count<unheard>() == 0 );
+
+	assert( bus.subscriber_count<button_clicked>() == 1 );
+	c1.disconnect();
+	assert( bus.subscriber_count<button_clicked>() == 0 );
+
+	bus.publish( button_clicked{ 5 } );
+	assert( pres.clicks == 3 );
+
+	assert( pac::event_index<button_clicked>() != pac::event_index<title_changed>() );
+}
+
+void toe_delivery_test()
+{
+	pac::event_bus bus;
+	pac::toe toe;
+	toe.launch( pac::toe::launch_type::async );
+
+	std::promise<std::thread::id> delivered;
+
+	auto con = bus.subscribe_on<title_changed>(
+		toe,
+		[&delivered]( title_changed const& e )
+		{
+			assert( e.title == "remote" );
+			delivered.set_value( std::this_thread::get_id() );
+		} );
+
+	{
+		title_changed e{ "remote" };
+		bus.publish( e );
+	}
+
+	auto tid = delivered.get_future().get();
+	assert( tid != std::this_thread::get_id() );
+
+	toe.quit();
+	toe.join();
+}
+
+// Counts the copies made of it
+struct counting_subscriber
+{
+	int *copies;
+	int *received;
+
+	counting_subscriber( int *c, int *r )
+		: copies( c ), received( r )
+	{}
+
+	counting_subscriber( counting_subscriber const& other )
+		: copies( other.copies ), received( other.received )
+	{
+		++*copies;
+	}
+
+	counting_subscriber( counting_subscriber&& ) = default;
+
+	void operator()( button_clicked const& )
+	{
+		++*received;
+	}
+};
+
+void toe_sharing_test()
+{
+	pac::event_bus bus;
+	pac::toe toe;
+
+	int copies = 0;
+	int received = 0;
+
+	auto con = bus.subscribe_on<button_clicked>(
+		toe, counting_subscriber( &copies, &received ) );
+
+	// the subscriber is shared with each posted run, not copied into it
+	for ( int i = 0; i < 100; ++i )
+		bus.publish( button_clicked{ i } );
+
+	std::promise<void> done;
+	toe.add_callback( pac::callback<void()>( [&done]() { done.set_value(); } ) );
+	toe.launch( pac::toe::launch_type::async );
+	done.get_future().wait();
+
+	assert( received == 100 );
+	assert( copies == 0 );
+
+	toe.quit();
+	toe.join();
+}
+
+int main(int argc, char *argv[])
+{
+	dispatch_test();
+
+	toe_delivery_test();
+
+	toe_sharing_test();
+
+	std::cout << "Success: All tests passed!\n";
+
+	return 0;
+}
@@ -0,0 +1,124 @@
+#include "keyed-signal.hpp"
+
+#include <cassert>
+#include <iostream>
+#include <string>
+#include <vector>
+
+struct entity_view
+{
+	int id;
+	int updates = 0;
+
+	entity_view( int i )
+		: id( i )
+	{}
+
+	void OnUpdate( std::string const& )
+	{
+		++updates;
+	}
+};
+
+void keyed_routing_test()
+{
+	pac::keyed_signal< int, void( std::string const& ) > updated;
+
+	std::vector<entity_view> views{ 1, 2, 3 };
+	std::vector<pac::connection> cons;
+
+	for ( auto& v : views )
+		cons.push_back( updated.connect( v.id, &entity_view::OnUpdate, &v ) );
+
+	std::vector<int> seen;
+	auto any = updated.connect_any(
+		[&seen]( int const& id, std::string const& ) { seen.push_back( id ); } );
+
+	updated.emit( 2, "moved" );
+	updated.emit( 2, "renamed" );
+	updated.emit( 3, "moved" );
+
+	// an entity nobody subscribed to only reaches the wildcard
+	updated.emit( 42, "created" );
+
+	assert( views[0].updates == 0 );
+	assert( views[1].updates == 2 );
+	assert( views[2].updates == 1 );
+	assert( ( seen == std::vector<int>{ 2, 2, 3, 42 } ) );
+
+	assert( updated.slot_count( 2 ) == 1 );
+	assert( updated.slot_count( 42 ) == 0 );
+
+	cons[1].disconnect();
+	updated.emit( 2, "moved" );
+	assert( views[1].updates == 2 );
+	assert( updated.slot_count( 2 ) == 0 );
+}
+
+void keyed_results_test()
+{
+	pac::keyed_signal< std::string, int( int ) > scale;
+
+	auto c1 = scale.connect( "double", []( int x ) { return x * 2; } );
+	auto c2 = scale.connect( "triple", []( int x ) { return x * 3; } );
+	auto c3 = scale.connect_any( []( std::string const&, int x ) { return -x; } );
+
+	assert( ( scale.emit( "double", 5 ) == std::vector<int>{ 10, -5 } ) );
+	assert( ( scale.emit( "triple", 5 ) == std::vector<int>{ 15, -5 } ) );
+	assert( ( scale.emit( "none", 5 ) == std::vector<int>{ -5 } ) );
+}
+
+void keyed_churn_test()
+{
+	pac::keyed_signal< int, void( int ) > updated;
+	int hits = 0;
+
+	// per-entity keys that come and go must not pile up channels
+	for ( int key = 0; key < 10000; ++key ) {
+		auto con = updated.connect( key, [&hits]( int ) { ++hits; } );
+		updated.emit( key, 0 );
+		con.disconnect();
+		assert( updated.channel_count() <= 32 );
+	}
+	assert( hits == 10000 );
+
+	// emitting to a key whose slots are gone drops its channel
+	auto gone = updated.connect( -1, [&hits]( int ) { ++hits; } );
+	gone.disconnect();
+	updated.emit( -1, 0 );
+	assert( updated.slot_count( -1 ) == 0 );
+	updated.compact();
+	assert( updated.channel_count() == 0 );
+
+	// a slot dropping its own channel's last connection mid-emission, and
+	// connecting other keys while it runs, leaves the map consistent
+	pac::connection self;
+	std::vector<pac::connection> spawned;
+	self = updated.connect( 7, [&]( int ) {
+		self.disconnect();
+		for ( int key = 100; key < 200; ++key )
+			spawned.push_back( updated.connect( key, [&hits]( int ) { ++hits; } ) );
+		updated.emit( 150, 0 );
+	} );
+	updated.emit( 7, 0 );
+	assert( updated.slot_count( 7 ) == 0 );
+	assert( updated.channel_count() == 100 );
+	assert( hits == 10001 );
+
+	spawned.clear();
+	updated.compact();
+	assert( updated.channel_count() == 0 );
+}
+
+int main(int argc, char *argv[])
+{
+	keyed_routing_test();
+
+	keyed_results_test();
+
+	keyed_churn_test();
+
+	std::cout << "Success: All tests passed!\n";
+
+	return 0;
+}
@@ -0,0 +1,78 @@
+#include "memoize.hpp"
+#include "signal.hpp"
+
+#include <cassert>
+#include <iostream>
+#include <string>
+
+int evaluations = 0;
+
+int layout_width( int columns, int padding )
+{
+	++evaluations;
+	return columns * 8 + padding * 2;
+}
+
+void basic_memoize_test()
+{
+	evaluations = 0;
+	auto width = pac::memoize( pac::make_callback( layout_width ), 2 );
+
+	assert( width( 10, 1 ) == 82 );
+	assert( width( 10, 1 ) == 82 );
+	assert( evaluations == 1 );
+	assert( width.hits() == 1 && width.misses() == 1 );
+
+	width( 20, 1 );
+	width( 10, 1 );
+	assert( evaluations == 2 );
+
+	// capacity is two: (30, 1) evicts the least recently used (20, 1)
+	width( 30, 1 );
+	assert( width.size() == 2 );
+	width( 10, 1 );
+	assert( evaluations == 3 );
+	width( 20, 1 );
+	assert( evaluations == 4 );
+	assert( width.hits() == 3 && width.misses() == 4 );
+
+	width.clear();
+	width( 10, 1 );
+	assert( evaluations == 5 );
+}
+
+void signal_memoize_test()
+{
+	pac::callback< std::string( std::string const&, int ) > format =
+		[]( std::string const& unit, int value )
+		{
+			++evaluations;
+			return std::to_string( value ) + unit;
+		};
+
+	evaluations = 0;
+	auto memo = pac::memoize( format, 16 );
+
+	pac::signal< std::string( std::string const&, int ) > sig;
+	auto con = sig.connect( memo );
+
+	for ( int i = 0; i < 10; ++i ) {
+		auto res = sig.emit( "px", i % 2 );
+		assert( res.size() == 1 && res[0] == std::to_string( i % 2 ) + "px" );
+	}
+
+	// the slot shares the cache with memo
+	assert( evaluations == 2 );
+	assert( memo.hits() == 8 && memo.misses() == 2 );
+}
+
+int main(int argc, char *argv[])
+{
+	basic_memoize_test();
+
+	signal_memoize_test();
+
+	std::cout << "Success: All tests passed!\n";
+
+	return 0;
+}
@@ -0,0 +1,206 @@
+#include "memory-resource.hpp"
+#include "callback.hpp"
+#include "signal.hpp"
+#include "context.hpp"
+
+#include <array>
+#include <cassert>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <new>
+
+namespace {
+
+bool counting = false;
+std::size_t global_allocations = 0;
+
+}
+
+void *operator new( std::size_t size )
+{
+	if ( counting )
+		++global_allocations;
+
+	if ( void *p = std::malloc( size ? size : 1 ) )
+		return p;
+
+	throw std::bad_alloc();
+}
+
+void operator delete( void *p ) noexcept
+{
+	std::free( p );
+}
+
+void operator delete( void *p, std::size_t ) noexcept
+{
+	std::free( p );
+}
+
+struct counting_scope
+{
+	counting_scope()
+	{
+		global_allocations = 0;
+		counting = true;
+	}
+
+	~counting_scope()
+	{
+		counting = false;
+	}
+};
+
+struct receiver
+{
+	int total = 0;
+
+	void add( int x )
+	{
+		total += x;
+	}
+};
+
+void monotonic_test()
+{
+	alignas(std::max_align_t) static char buffer[64];
+	pac::monotonic_buffer_resource arena( buffer, sizeof(buffer) );
+
+	auto p1 = arena.allocate( 24, 8 );
+	auto p2 = arena.allocate( 24, 16 );
+	assert( reinterpret_cast<std::uintptr_t>( p2 ) % 16 == 0 );
+	assert( p1 != p2 );
+
+	// exhausting the buffer spills over to upstream
+	auto p3 = arena.allocate( 128 );
+	assert( p3 != nullptr );
+	arena.release();
+}
+
+void pool_test()
+{
+	pac::pool_resource pool;
+
+	auto p1 = pool.allocate( 40, 8 );
+	pool.deallocate( p1, 40, 8 );
+	auto p2 = pool.allocate( 48, 8 );
+	// same size class is recycled
+	assert( p1 == p2 );
+	pool.deallocate( p2, 48, 8 );
+
+	auto big = pool.allocate( 4096 );
+	pool.deallocate( big, 4096 );
+}
+
+void inline_buffer_test()
+{
+	pac::inline_buffer_resource<64> local( pac::null_memory_resource() );
+
+	auto p1 = local.allocate( 24, 8 );
+	auto p2 = local.allocate( 24, 16 );
+	assert( reinterpret_cast<std::uintptr_t>( p2 ) % 16 == 0 );
+
+	// the buffer starts over once it is empty again
+	local.deallocate( p1, 24, 8 );
+	local.deallocate( p2, 24, 16 );
+	assert( local.allocate( 48, 8 ) == p1 );
+}
+
+// Signals are a word until connected, and one allocation with one slot
+void small_signal_test()
+{
+	static_assert( sizeof(pac::signal<void(int)>) == sizeof(void *),
+	               "an unconnected signal is a single word" );
+
+	receiver r;
+
+	counting_scope scope;
+	{
+		pac::signal<void(int)> sig;
+		sig.emit( 1 );
+		assert( sig.slot_count() == 0 );
+		assert( global_allocations == 0 );
+
+		auto con = sig.connect( &receiver::add, &r );
+		sig.emit( 1 );
+		assert( global_allocations == 1 );
+
+		con.disconnect();
+		con = sig.connect( &receiver::add, &r );
+		sig.emit( 1 );
+		assert( global_allocations == 1 );
+		assert( r.total == 2 );
+	}
+}
+
+void zero_global_allocations_test()
+{
+	alignas(std::max_align_t) static char buffer[16384];
+	pac::monotonic_buffer_resource arena( buffer, sizeof(buffer),
+	                                      pac::null_memory_resource() );
+
+	receiver r;
+	std::array<long, 8> big{ { 1 } };
+	auto shared = std::make_shared<receiver>();
+
+	counting_scope scope;
+	{
+		pac::signal<void( int )> sig( &arena );
+
+		auto con1 = sig.connect( &receiver::add, &r );
+		auto con2 = sig.connect( [&r]( int x ) { r.total += x; } );
+		auto con3 = sig.connect( [&r, big]( int x ) { r.total += x + big[0]; } );
+		auto con4 = sig.connect( PAC_DELEGATE( &receiver::add, &r ) );
+
+		// too big to store inline, so the binding comes from the arena
+		auto con6 = sig.connect( &receiver::add, shared );
+
+		sig.emit( 1 );
+		assert( r.total == 5 );
+
+		con2.disconnect();
+		sig.emit( 1 );
+		assert( r.total == 9 );
+		assert( shared->total == 2 );
+
+		pac::signal<int( int )> sigret( &arena );
+		auto con5 = sigret.connect( []( int x ) { return x * 2; } );
+		int sum = 0;
+		sigret.emit_with( [&sum]( int x ) { sum += x; }, 21 );
+		assert( sum == 42 );
+
+		pac::context ctxt( &arena );
+		ctxt.add_callback(
+			pac::callback<void( int )>( std::allocator_arg, &arena,
+			                            [&r, big]( int x ) { r.total += x; } ),
+			100 );
+		ctxt.add_callback( PAC_DELEGATE( &receiver::add, &r ), 1000 );
+
+		while ( auto run = ctxt.next_runnable() )
+			run.run();
+
+		assert( r.total == 1109 );
+	}
+
+	std::cout << "global allocations: " << global_allocations << "\n";
+	assert( global_allocations == 0 );
+}
+
+int main(int argc, char *argv[])
+{
+	monotonic_test();
+
+	pool_test();
+
+	zero_global_allocations_test();
+
+	inline_buffer_test();
+
+	small_signal_test();
+
+	std::cout << "Success: All tests passed!\n";
+
+	return 0;
+}
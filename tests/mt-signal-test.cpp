@@ -0,0 +1,120 @@
+#include "signal.hpp"
+#include "signal-forward.hpp"
+
+#include <atomic>
+#include <cassert>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+const int producers = 4;
+const int emissions = 20000;
+
+void stress_test()
+{
+	pac::signal< void(int), pac::mt_policy > sig;
+
+	std::atomic<long> permanent{ 0 };
+	std::atomic<long> transient{ 0 };
+	std::atomic<bool> producing{ true };
+
+	auto con = sig.connect( [&permanent]( int x ) { permanent += x; } );
+
+	// connect, block and disconnect slots while the producers emit
+	std::vector<std::thread> churners;
+	for ( int c = 0; c < 2; ++c ) {
+		churners.emplace_back(
+			[&]()
+			{
+				while ( producing ) {
+					auto tmp = sig.connect( [&transient]( int ) { ++transient; } );
+					tmp.block();
+					tmp.unblock();
+					// tmp disconnects as it goes out of scope
+				}
+			} );
+	}
+
+	std::vector<std::thread> threads;
+	for ( int p = 0; p < producers; ++p ) {
+		threads.emplace_back(
+			[&sig]()
+			{
+				for ( int i = 0; i < emissions; ++i ) {
+					sig.emit( 1 );
+
+					if ( i % 64 == 0 )
+						std::this_thread::yield();
+				}
+			} );
+	}
+
+	for ( auto& t : threads )
+		t.join();
+
+	producing = false;
+	for ( auto& t : churners )
+		t.join();
+
+	assert( permanent == producers * emissions );
+	assert( sig.slot_count() == 1 );
+
+	std::cout << "transient slot invocations: " << transient << "\n";
+}
+
+void combiner_test()
+{
+	pac::signal< int(int), pac::mt_policy > sig;
+
+	auto c1 = sig.connect( []( int x ) { return x; } );
+	auto c2 = sig.connect( []( int x ) { return x * 10; } );
+
+	assert( sig.emit_with( pac::fold( 0, std::plus<int>() ), 2 ) == 22 );
+	assert( sig.emit_with<pac::last_value>( 2 ) == 20 );
+
+	auto results = sig.emit( 1 );
+	assert( ( results == std::vector<int>{ 1, 10 } ) );
+
+	// forwarding works the same as for single threaded signals
+	pac::signal_forward< decltype( sig ), int( int ) > fwd( sig );
+	auto c3 = fwd.connect( []( int x ) { return x + 100; } );
+	assert( sig.emit_with<pac::last_value>( 1 ) == 101 );
+
+	c1.disconnect();
+	assert( sig.slot_count() == 2 );
+}
+
+void reclaim_test()
+{
+	pac::signal< void(int), pac::mt_policy > sig;
+	int calls = 0;
+
+	// the snapshot replaced by a disconnect mid-emission outlives it
+	pac::connection self;
+	self = sig.connect( [&]( int ) { ++calls; self.disconnect(); } );
+	auto other = sig.connect( [&calls]( int ) { ++calls; } );
+	sig.emit( 0 );
+	sig.emit( 0 );
+	assert( calls == 3 );
+	assert( sig.slot_count() == 1 );
+
+	// freeing a retired slot may disconnect others from the same signal
+	auto owned = std::make_shared<pac::connection>( std::move( other ) );
+	auto holder = sig.connect( [owned]( int ) {} );
+	owned.reset();
+	holder.disconnect();
+	assert( sig.slot_count() == 0 );
+}
+
+int main(int argc, char *argv[])
+{
+	stress_test();
+
+	reclaim_test();
+
+	combiner_test();
+
+	std::cout << "Success: All tests passed!\n";
+
+	return 0;
+}
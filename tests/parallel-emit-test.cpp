@@ -0,0 +1,118 @@
+#include "signal.hpp"
+#include "toe-pool.hpp"
+
+#include <atomic>
+#include <cassert>
+#include <iostream>
+#include <mutex>
+#include <set>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+void parallel_results_test()
+{
+	pac::toe_pool pool( 3 );
+	pac::signal<int(int)> sig;
+	std::vector<pac::connection> cons;
+
+	for ( int i = 0; i < 100; ++i )
+		cons.push_back( sig.connect( [i]( int x ) { return x * 1000 + i; } ) );
+
+	// blocked slots are left out, the rest come back in connection order
+	cons[5].block();
+
+	auto results = sig.emit_parallel( pool, 7 );
+	assert( results.size() == 99 );
+
+	int expected = 0;
+	for ( auto r : results ) {
+		if ( expected == 5 )
+			++expected;
+
+		assert( r == 7000 + expected );
+		++expected;
+	}
+
+	// fewer slots than workers
+	pac::signal<int(int)> small;
+	auto con = small.connect( []( int x ) { return x + 1; } );
+	assert( ( small.emit_parallel( pool, 1 ) == std::vector<int>{ 2 } ) );
+
+	pac::signal<int(int)> empty;
+	assert( empty.emit_parallel( pool, 1 ).empty() );
+}
+
+void parallel_threads_test()
+{
+	pac::toe_pool pool( 4 );
+	pac::signal<void()> sig;
+
+	std::mutex mutex;
+	std::set<std::thread::id> threads;
+	std::atomic<int> calls{ 0 };
+
+	for ( int i = 0; i < 50; ++i ) {
+		sig.connect(
+			[&]()
+			{
+				++calls;
+				std::lock_guard<std::mutex> lock( mutex );
+				threads.insert( std::this_thread::get_id() );
+			} ).detach();
+	}
+
+	sig.emit_parallel( pool );
+
+	// every slot ran once, spread over the caller and the four workers
+	assert( calls == 50 );
+	assert( threads.size() == 5 );
+}
+
+void parallel_exception_test()
+{
+	pac::toe_pool pool( 2 );
+	pac::signal<int(int)> sig;
+	std::atomic<int> calls{ 0 };
+
+	// the last run goes to a worker; its exception reaches the caller
+	for ( int i = 0; i < 8; ++i ) {
+		sig.connect(
+			[&calls, i]( int x )
+			{
+				++calls;
+				if ( i == 7 )
+					throw std::runtime_error( "x" );
+				return x;
+			} ).detach();
+	}
+
+	bool caught = false;
+	try {
+		sig.emit_parallel( pool, 1 );
+	}
+	catch ( std::runtime_error const& ) {
+		caught = true;
+	}
+
+	assert( caught );
+	assert( calls == 8 );
+
+	// the pool is still usable afterwards
+	pac::signal<int(int)> ok;
+	auto con = ok.connect( []( int x ) { return x + 1; } );
+	assert( ( ok.emit_parallel( pool, 1 ) == std::vector<int>{ 2 } ) );
+}
+
+int main(int argc, char *argv[])
+{
+	parallel_results_test();
+
+	parallel_threads_test();
+
+	parallel_exception_test();
+
+	std::cout << "Success: All tests passed!\n";
+
+	return 0;
+}
@@ -0,0 +1,76 @@
+#include "queued-signal.hpp"
+
+#include <cassert>
+#include <iostream>
+#include <string>
+#include <vector>
+
+void queued_emit_test()
+{
+	pac::queued_signal< void( std::string const&, int ) > sig( 4 );
+	std::vector<std::string> seen;
+
+	auto con = sig.connect(
+		[&seen]( std::string const& name, int value )
+		{
+			seen.push_back( name + "=" + std::to_string( value ) );
+		} );
+
+	sig.emit( "width", 10 );
+	sig.emit( "height", 20 );
+
+	// nothing is delivered until flushed
+	assert( seen.empty() );
+	assert( sig.pending() == 2 );
+
+	assert( sig.flush() == 2 );
+	assert( ( seen == std::vector<std::string>{ "width=10", "height=20" } ) );
+	assert( sig.pending() == 0 );
+	assert( sig.flush() == 0 );
+}
+
+void batch_receiver_test()
+{
+	pac::queued_signal< void( int ) > sig;
+	std::vector<std::size_t> batch_sizes;
+	int sum = 0;
+
+	auto con = sig.connect_batch(
+		[&]( pac::span<int const> values )
+		{
+			batch_sizes.push_back( values.size() );
+			for ( auto v : values )
+				sum += v;
+		} );
+
+	// emissions from a receiver during a flush wait for the next flush
+	auto echo = sig.connect(
+		[&sig]( int x )
+		{
+			if ( x > 0 )
+				sig.emit( -x );
+		} );
+
+	for ( int i = 1; i <= 100; ++i )
+		sig.emit( i );
+
+	assert( sig.flush() == 100 );
+	assert( batch_sizes.size() == 1 && batch_sizes[0] == 100 );
+	assert( sum == 5050 );
+	assert( sig.pending() == 100 );
+
+	assert( sig.flush() == 100 );
+	assert( sum == 0 );
+	assert( sig.pending() == 0 );
+}
+
+int main(int argc, char *argv[])
+{
+	queued_emit_test();
+
+	batch_receiver_test();
+
+	std::cout << "Success: All tests passed!\n";
+
+	return 0;
+}
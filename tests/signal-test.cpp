@@ -3,6 +3,7 @@
 
 #include <iostream>
 #include <algorithm>
+#include <numeric>
 #include <memory>
 
 #include <cassert>
@@ -77,8 +78,599 @@ int sigfwd2_cb( int x )
 	return std::move(ret);
 }
 
+struct Tracked
+{
+	int& hits;
+
+	Tracked( int& h )
+		: hits( h )
+	{}
+
+	void OnEvent( int x )
+	{
+		hits += x;
+	}
+};
+
+void weak_tracking_test()
+{
+	int hits = 0;
+	pac::signal<void(int)> sig;
+
+	auto alive = std::make_shared<Tracked>( hits );
+	auto dying = std::make_shared<Tracked>( hits );
+
+	sig.connect( &Tracked::OnEvent, std::weak_ptr<Tracked>( alive ) ).detach();
+	sig.connect( &Tracked::OnEvent, std::weak_ptr<Tracked>( dying ) ).detach();
+	assert( sig.slot_count() == 2 );
+
+	sig.emit( 1 );
+	assert( hits == 2 );
+
+	dying.reset();
+
+	// the expired receiver is skipped and purged in the same emission
+	sig.emit( 1 );
+	assert( hits == 3 );
+	assert( sig.slot_count() == 1 );
+}
+
+pac::connection connect_through( pac::signal<void(int)>& sig, Tracked *target )
+{
+	Tracked *local = target;
+	return sig.connect( &Tracked::OnEvent, local );
+}
+
+pac::callback<void(int)> bind_through( Tracked *target )
+{
+	return pac::make_callback( &Tracked::OnEvent, target );
+}
+
+void pointer_binding_test()
+{
+	int hits = 0;
+	Tracked receiver( hits );
+	pac::signal<void(int)> sig;
+
+	// the slot keeps its own copy of the pointer, not the dead local
+	auto con = connect_through( sig, &receiver );
+	sig.emit( 1 );
+	sig.emit( 2 );
+	assert( hits == 3 );
+
+	auto cb = bind_through( &receiver );
+	cb( 4 );
+	assert( hits == 7 );
+}
+
+void slot_order_test()
+{
+	std::vector<int> order;
+	pac::signal<void(int)> sig;
+	std::vector<pac::connection> cons;
+
+	for ( int i = 0; i < 4; ++i )
+		cons.push_back( sig.connect( [&order, i]( int ) { order.push_back( i ); } ) );
+
+	cons[1].disconnect();
+	cons.push_back( sig.connect( [&order]( int ) { order.push_back( 4 ); } ) );
+
+	sig.emit( 0 );
+	assert( ( order == std::vector<int>{ 0, 2, 3, 4 } ) );
+
+	// connecting and disconnecting from inside a slot takes effect after
+	// the emission, without disturbing the slots being iterated
+	pac::connection late;
+	auto mutator = sig.connect(
+		[&]( int )
+		{
+			order.push_back( 5 );
+			cons[0].disconnect();
+			late = sig.connect( [&order]( int ) { order.push_back( 6 ); } );
+		} );
+
+	order.clear();
+	sig.emit( 0 );
+	assert( ( order == std::vector<int>{ 0, 2, 3, 4, 5 } ) );
+
+	mutator.disconnect();
+	order.clear();
+	sig.emit( 0 );
+	assert( ( order == std::vector<int>{ 2, 3, 4, 6 } ) );
+	assert( sig.slot_count() == 4 );
+
+	// a stale id must not reach the slot that reused its storage
+	auto stale = cons[2].id();
+	cons[2].disconnect();
+	sig.connect( [&order]( int ) { order.push_back( 7 ); } ).detach();
+	sig.disconnect( stale );
+	order.clear();
+	sig.emit( 0 );
+	assert( ( order == std::vector<int>{ 3, 4, 6, 7 } ) );
+}
+
+void deferred_deletion_test()
+{
+	int hits = 0;
+	pac::signal<void(int)> sig;
+
+	// the owning slot holds the only connection to counter; releasing it
+	// disconnects counter while the signal is purging
+	pac::connection owner;
+	{
+		auto counter = std::make_shared<pac::connection>(
+			sig.connect( [&hits]( int ) { ++hits; } ) );
+		owner = sig.connect( [counter]( int ) {} );
+	}
+	assert( sig.slot_count() == 2 );
+
+	owner.disconnect();
+	assert( sig.slot_count() == 0 );
+	sig.emit( 0 );
+	assert( hits == 0 );
+
+	// nested emissions disconnect slots that the outer one skips
+	std::vector<pac::connection> cons;
+	for ( int i = 0; i < 3; ++i )
+		cons.push_back( sig.connect( [&hits]( int ) { ++hits; } ) );
+
+	auto nested = sig.connect(
+		[&]( int depth )
+		{
+			if ( depth == 0 ) {
+				sig.emit( 1 );
+				cons[2].disconnect();
+				return;
+			}
+
+			cons[0].disconnect();
+			cons[1].disconnect();
+		} );
+
+	cons.push_back( sig.connect( [&hits]( int ) { hits += 10; } ) );
+
+	sig.emit( 0 );
+	// outer: three counters; inner: three counters plus the last slot;
+	// back in the outer emission the last slot still runs
+	assert( hits == 3 + 3 + 10 + 10 );
+	assert( sig.slot_count() == 2 );
+
+	hits = 0;
+	sig.emit( 1 );
+	assert( hits == 10 );
+}
+
+void blocked_order_test()
+{
+	std::vector<int> order;
+	pac::signal<void(int)> sig;
+	std::vector<pac::connection> cons;
+
+	// slot 0 blocks slot 3 when emitted with 1
+	cons.push_back( sig.connect(
+		[&]( int block )
+		{
+			order.push_back( 0 );
+			if ( block )
+				cons[3].block();
+		} ) );
+
+	for ( int i = 1; i < 5; ++i )
+		cons.push_back( sig.connect( [&order, i]( int ) { order.push_back( i ); } ) );
+
+	{
+		pac::connection_block b1{ cons[1] };
+		pac::connection_block b3{ cons[3] };
+
+		sig.emit( 0 );
+		assert( ( order == std::vector<int>{ 0, 2, 4 } ) );
+	}
+
+	// unblocked slots run in their original place
+	order.clear();
+	sig.emit( 0 );
+	assert( ( order == std::vector<int>{ 0, 1, 2, 3, 4 } ) );
+
+	// a slot blocked from inside an emission is skipped by it
+	order.clear();
+	sig.emit( 1 );
+	assert( ( order == std::vector<int>{ 0, 1, 2, 4 } ) );
+
+	cons[3].unblock();
+	order.clear();
+	sig.emit( 0 );
+	assert( ( order == std::vector<int>{ 0, 1, 2, 3, 4 } ) );
+
+	// a slot left out by a rebuild while blocked is put back in its place
+	cons[2].block();
+	cons.push_back( sig.connect( [&order]( int ) { order.push_back( 5 ); } ) );
+	order.clear();
+	sig.emit( 0 );
+	assert( ( order == std::vector<int>{ 0, 1, 3, 4, 5 } ) );
+
+	cons[2].unblock();
+	order.clear();
+	sig.emit( 0 );
+	assert( ( order == std::vector<int>{ 0, 1, 2, 3, 4, 5 } ) );
+
+	// and likewise when unblocked from inside an emission
+	cons[4].block();
+	cons.push_back( sig.connect( [&]( int )
+	                             {
+		                             order.push_back( 6 );
+		                             cons[4].unblock();
+	                             } ) );
+	order.clear();
+	sig.emit( 0 );
+	assert( ( order == std::vector<int>{ 0, 1, 2, 3, 5, 6 } ) );
+
+	order.clear();
+	sig.emit( 0 );
+	assert( ( order == std::vector<int>{ 0, 1, 2, 3, 4, 5, 6 } ) );
+}
+
+void combiner_test()
+{
+	pac::signal<int(int)> sig;
+	int calls = 0;
+
+	assert( sig.emit_with<pac::last_value>( 1 ) == 0 );
+
+	auto c1 = sig.connect( [&calls]( int x ) { ++calls; return x; } );
+	auto c2 = sig.connect( [&calls]( int x ) { ++calls; return x * 3; } );
+	auto c3 = sig.connect( [&calls]( int x ) { ++calls; return x / 2; } );
+
+	assert( sig.emit_with<pac::last_value>( 5 ) == 2 );
+	assert( calls == 3 );
+
+	int max = sig.emit_with( pac::fold( 0, []( int a, int b ) { return std::max( a, b ); } ), 5 );
+	assert( max == 15 );
+
+	auto sum = pac::fold( 100, std::plus<int>() );
+	sig.emit_with( sum, 1 );
+	assert( sum.result() == 100 + 1 + 3 + 0 );
+
+	// the remaining slots are skipped once the answer is known
+	calls = 0;
+	assert( sig.emit_with<pac::any_of>( 1 ) );
+	assert( calls == 1 );
+
+	calls = 0;
+	assert( !sig.emit_with<pac::any_of>( 0 ) );
+	assert( calls == 3 );
+
+	int a = 1, b = 2;
+	pac::signal<int *(int)> lookup;
+	lookup.connect( []( int ) -> int * { return nullptr; } ).detach();
+	lookup.connect( [&a]( int key ) { return key == 1 ? &a : nullptr; } ).detach();
+	lookup.connect( [&b]( int ) { return &b; } ).detach();
+
+	assert( lookup.emit_with<pac::first_non_null>( 1 ) == &a );
+	assert( lookup.emit_with<pac::first_non_null>( 2 ) == &b );
+}
+
+void connection_handle_test()
+{
+	int hits = 0;
+	pac::connection con;
+
+	// connections outliving their signal go stale harmlessly
+	{
+		pac::signal<void(int)> sig;
+		con = sig.connect( [&hits]( int ) { ++hits; } );
+	}
+	con.block();
+	con.disconnect();
+
+	// a moved signal keeps the connections made before the move
+	pac::signal<void(int)> moved;
+	con = moved.connect( [&hits]( int ) { ++hits; } );
+
+	pac::signal<void(int)> sig( std::move( moved ) );
+	con.block();
+	sig.emit( 0 );
+	assert( hits == 0 );
+
+	con.unblock();
+	sig.emit( 0 );
+	assert( hits == 1 );
+
+	// moving a connection hands over the slot; the moved-from one is empty
+	pac::connection other( std::move( con ) );
+	con.disconnect();
+	assert( sig.slot_count() == 1 );
+
+	other = pac::connection();
+	assert( sig.slot_count() == 0 );
+
+	// a signal moved onto another drops the connections it replaces
+	pac::signal<void(int)> replaced;
+	auto stale = replaced.connect( [&hits]( int ) { hits += 10; } );
+	replaced = std::move( sig );
+	stale.disconnect();
+	con = replaced.connect( [&hits]( int ) { ++hits; } );
+	replaced.emit( 0 );
+	assert( hits == 2 );
+
+	// enough signals to outgrow the registry's first chunk, moved around
+	// as the vector reallocates
+	std::vector< pac::signal<void(int)> > many;
+	std::vector<pac::connection> cons;
+	for ( int i = 0; i < 300; ++i ) {
+		many.emplace_back();
+		cons.push_back( many.back().connect( [&hits]( int ) { ++hits; } ) );
+	}
+
+	hits = 0;
+	cons[7].disconnect();
+	cons[250].block();
+	for ( auto& s : many )
+		s.emit( 0 );
+	assert( hits == 298 );
+}
+
+void connection_group_test()
+{
+	int hits = 0;
+	pac::signal<void(int)> clicked;
+	pac::signal<void(int)> resized;
+	pac::signal<void(int), pac::mt_policy> shared;
+	pac::connection other = clicked.connect( [&hits]( int ) { hits += 100; } );
+
+	{
+		pac::connection_group panel;
+
+		for ( int i = 0; i < 3; ++i ) {
+			clicked.connect( panel, [&hits]( int ) { ++hits; } );
+			resized.connect( panel, [&hits]( int ) { ++hits; } );
+		}
+		shared.connect( panel, [&hits]( int ) { ++hits; } );
+
+		clicked.emit( 0 );
+		resized.emit( 0 );
+		shared.emit( 0 );
+		assert( hits == 100 + 7 );
+
+		panel.block();
+		assert( panel.blocked() );
+		hits = 0;
+		clicked.emit( 0 );
+		resized.emit( 0 );
+		shared.emit( 0 );
+		assert( hits == 100 );
+
+		panel.unblock();
+		hits = 0;
+		resized.emit( 0 );
+		assert( hits == 3 );
+
+		// a disconnected group's slots are skipped and purged on the next
+		// emission; the group is fresh for later connections
+		panel.disconnect();
+		assert( clicked.slot_count() == 4 );
+		hits = 0;
+		clicked.emit( 0 );
+		assert( hits == 100 );
+		assert( clicked.slot_count() == 1 );
+
+		clicked.connect( panel, [&hits]( int ) { hits += 10; } );
+		hits = 0;
+		clicked.emit( 0 );
+		assert( hits == 110 );
+	}
+
+	// destroying the group disconnects it
+	hits = 0;
+	clicked.emit( 0 );
+	resized.emit( 0 );
+	shared.emit( 0 );
+	assert( hits == 100 );
+	assert( clicked.slot_count() == 1 );
+	assert( resized.slot_count() == 0 );
+	assert( shared.slot_count() == 0 );
+}
+
+void priority_test()
+{
+	std::vector<int> order;
+	pac::signal<void(int)> sig;
+	std::vector<pac::connection> cons;
+
+	auto log = [&order]( int n ) { return [&order, n]( int ) { order.push_back( n ); }; };
+
+	cons.push_back( sig.connect( log( 0 ) ) );
+	cons.push_back( sig.connect( 10, log( 1 ) ) );
+	cons.push_back( sig.connect( -5, log( 2 ) ) );
+	cons.push_back( sig.connect( 10, log( 3 ) ) );
+	cons.push_back( sig.connect( log( 4 ) ) );
+
+	sig.emit( 0 );
+	assert( ( order == std::vector<int>{ 1, 3, 0, 4, 2 } ) );
+
+	// disconnecting and blocking leave the order of the others alone, and
+	// connections made while emitting take their place afterwards
+	cons[3].disconnect();
+	cons[0].block();
+	cons.push_back( sig.connect(
+		5,
+		[&]( int )
+		{
+			order.push_back( 5 );
+			if ( cons.size() == 6 )
+				cons.push_back( sig.connect( 20, log( 6 ) ) );
+		} ) );
+
+	order.clear();
+	sig.emit( 0 );
+	assert( ( order == std::vector<int>{ 1, 5, 4, 2 } ) );
+
+	order.clear();
+	sig.emit( 0 );
+	assert( ( order == std::vector<int>{ 6, 1, 5, 4, 2 } ) );
+
+	// a slot placed ahead of a tombstone may reuse the tombstone's handle;
+	// it must still be the one its connection reaches
+	pac::signal<void(int)> tomb;
+	std::vector<pac::connection> tcons;
+	for ( int i = 0; i < 4; ++i )
+		tcons.push_back( tomb.connect( log( i ) ) );
+
+	tcons[1].disconnect();
+	auto high = tomb.connect( 5, log( 5 ) );
+	assert( tomb.slot_count() == 4 );
+
+	order.clear();
+	tomb.emit( 0 );
+	assert( ( order == std::vector<int>{ 5, 0, 2, 3 } ) );
+
+	high.block();
+	order.clear();
+	tomb.emit( 0 );
+	assert( ( order == std::vector<int>{ 0, 2, 3 } ) );
+
+	high.disconnect();
+	assert( tomb.slot_count() == 3 );
+	order.clear();
+	tomb.emit( 0 );
+	assert( ( order == std::vector<int>{ 0, 2, 3 } ) );
+}
+
+void stop_emission_test()
+{
+	std::vector<int> order;
+	pac::signal<void(int)> input;
+	pac::connection_group modal;
+
+	auto shortcut = input.connect(
+		100,
+		[&]( int key )
+		{
+			order.push_back( key );
+			if ( key == 'q' )
+				input.stop_emission();
+		} );
+	input.connect( modal, 50, [&]( int ) { order.push_back( -1 ); input.stop_emission(); } );
+	auto editor = input.connect( [&]( int key ) { order.push_back( key + 1 ); } );
+
+	// the modal overlay swallows everything the shortcut does not take
+	input.emit( 'a' );
+	input.emit( 'q' );
+	assert( ( order == std::vector<int>{ 'a', -1, 'q' } ) );
+
+	modal.disconnect();
+	order.clear();
+	input.emit( 'a' );
+	assert( ( order == std::vector<int>{ 'a', 'a' + 1 } ) );
+
+	// stopping a nested emission leaves the outer one running; outside of
+	// an emission stop_emission does nothing
+	input.stop_emission();
+	pac::signal<int(int)> sig;
+	auto outer = sig.connect(
+		[&]( int depth )
+		{
+			if ( depth == 0 )
+				sig.emit( 1 );
+			return 1;
+		} );
+	auto stopper = sig.connect(
+		[&]( int depth )
+		{
+			if ( depth == 1 )
+				sig.stop_emission();
+			return 2;
+		} );
+	auto last = sig.connect( []( int ) { return 3; } );
+
+	assert( ( sig.emit( 1 ) == std::vector<int>{ 1, 2 } ) );
+	assert( ( sig.emit( 0 ) == std::vector<int>{ 1, 2, 3 } ) );
+	assert( sig.emit_with<pac::last_value>( 1 ) == 2 );
+}
+
+void batch_test()
+{
+	pac::signal<void(int)> sig;
+	std::vector<int> order;
+	int sum = 0;
+	std::size_t batch_calls = 0;
+
+	auto c1 = sig.connect( [&order]( int x ) { order.push_back( x ); } );
+	auto c2 = sig.connect_batch(
+		[&]( pac::span<int const> values )
+		{
+			++batch_calls;
+			for ( auto v : values )
+				sum += v;
+		} );
+	auto c3 = sig.connect( [&order]( int x ) { order.push_back( -x ); } );
+
+	// slot major: every value reaches a slot before the next slot runs
+	std::vector<int> values{ 1, 2, 3 };
+	sig.emit_batch( values );
+	assert( ( order == std::vector<int>{ 1, 2, 3, -1, -2, -3 } ) );
+	assert( sum == 6 && batch_calls == 1 );
+
+	// a single emission reaches the batch receiver as a batch of one
+	sig.emit( 4 );
+	assert( sum == 10 && batch_calls == 2 );
+
+	pac::signal<int(int, int)> sig2;
+	int total = 0;
+	auto c4 = sig2.connect( [&total]( int a, int b ) { total += a * b; return 0; } );
+
+	std::vector< std::tuple<int, int> > pairs{ std::make_tuple( 2, 3 ),
+	                                           std::make_tuple( 4, 5 ) };
+	sig2.emit_batch( pairs );
+	assert( total == 26 );
+
+	// batch receivers move along with their signal
+	pac::monotonic_buffer_resource arena;
+	pac::signal<void(int)> source;
+	source.connect_batch(
+		[&sum]( pac::span<int const> values )
+		{
+			for ( auto v : values )
+				sum += v;
+		} ).detach();
+
+	pac::signal<void(int)> moved( std::move( source ) );
+	sum = 0;
+	moved.emit( 1 );
+	moved.emit_batch( values );
+	assert( sum == 7 );
+
+	pac::signal<void(int)> assigned( &arena );
+	assigned = std::move( moved );
+	sum = 0;
+	assigned.emit( 1 );
+	assigned.emit_batch( values );
+	assert( sum == 7 );
+}
+
 int main(int, char *[])
 {
+	weak_tracking_test();
+
+	pointer_binding_test();
+
+	slot_order_test();
+
+	deferred_deletion_test();
+
+	blocked_order_test();
+
+	combiner_test();
+
+	batch_test();
+
+	connection_handle_test();
+
+	connection_group_test();
+
+	priority_test();
+
+	stop_emission_test();
+
 	Server s;
 	auto c = std::make_shared<Client>( s );
 
@@ -110,6 +702,14 @@ int main(int, char *[])
 		assert( std::accumulate( r1.begin(), r1.end(), 0 ) == 10 );
 	}
 
+	{
+		auto con = s.sigadd.connect( another_add );
+		int sum = 0;
+		s.sigadd.emit_with( [&sum]( int r ) { sum += r; }, 5 );
+		// should be { 10, 12 } without collecting a results vector
+		assert( sum == 22 );
+	}
+
 	auto r2 = s.Sub( 3 );
 	for ( auto r : r2 )
 		std::cout << r << "\n";
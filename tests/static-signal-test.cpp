@@ -0,0 +1,92 @@
+#include "static-signal.hpp"
+
+#include <cassert>
+#include <iostream>
+#include <string>
+#include <vector>
+
+struct controller
+{
+	std::vector<std::string> log;
+
+	void OnButtonClicked( int button )
+	{
+		log.push_back( "clicked " + std::to_string( button ) );
+	}
+};
+
+void dispatch_test()
+{
+	controller ctrl;
+	int total = 0;
+
+	auto sig = pac::make_static_signal<void(int)>(
+		[&ctrl]( int button ) { ctrl.OnButtonClicked( button ); },
+		[&total]( int button ) { total += button; } );
+
+	static_assert( decltype(sig)::slot_count() == 2, "two slots" );
+
+	sig.emit( 3 );
+	sig.emit( 4 );
+
+	assert( ( ctrl.log == std::vector<std::string>{ "clicked 3", "clicked 4" } ) );
+	assert( total == 7 );
+}
+
+void builder_test()
+{
+	std::vector<int> order;
+
+	pac::static_signal<int(int)> empty;
+	auto sig = empty
+		.connect( [&order]( int x ) { order.push_back( 0 ); return x + 1; } )
+		.connect( [&order]( int x ) { order.push_back( 1 ); return x * 2; } )
+		.connect( [&order]( int x ) { order.push_back( 2 ); return x - 1; } );
+
+	static_assert( decltype(sig)::slot_count() == 3, "three slots" );
+
+	auto results = sig.emit( 5 );
+	assert( ( results == std::array<int, 3>{ { 6, 10, 4 } } ) );
+	assert( ( order == std::vector<int>{ 0, 1, 2 } ) );
+
+	assert( sig.emit_with<pac::last_value>( 5 ) == 4 );
+
+	// any_of stops at the first slot returning true
+	order.clear();
+	auto handled = pac::make_static_signal<bool(int)>(
+		[&order]( int ) { order.push_back( 0 ); return false; },
+		[&order]( int x ) { order.push_back( 1 ); return x > 0; },
+		[&order]( int ) { order.push_back( 2 ); return true; } );
+
+	assert( handled.emit_with<pac::any_of>( 1 ) );
+	assert( ( order == std::vector<int>{ 0, 1 } ) );
+
+	order.clear();
+	assert( handled.emit_with<pac::any_of>( -1 ) );
+	assert( ( order == std::vector<int>{ 0, 1, 2 } ) );
+}
+
+void argument_test()
+{
+	// every slot sees the same argument; none of them may move from it
+	std::string seen;
+	auto sig = pac::make_static_signal<void(std::string)>(
+		[&seen]( std::string const& s ) { seen += s; },
+		[&seen]( std::string const& s ) { seen += s; } );
+
+	sig.emit( std::string( "ab" ) );
+	assert( seen == "abab" );
+}
+
+int main(int argc, char *argv[])
+{
+	dispatch_test();
+
+	builder_test();
+
+	argument_test();
+
+	std::cout << "Success: All tests passed!\n";
+
+	return 0;
+}